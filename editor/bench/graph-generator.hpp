@@ -0,0 +1,195 @@
+#pragma once
+
+#include "graph.hpp"
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <vector>
+
+// Generated graphs of a given size and shape. Nodes are bare Graph nodes with two inputs and one output, the bench
+// builds without ImGui so the material nodes and what draws them aren't available.
+namespace GraphGenerator
+{
+
+struct Node : Graph::Node
+{
+    Ptr clone(std::pmr::memory_resource& resource) const override
+    {
+        return Graph::makeNode<Node>(resource, *this);
+    }
+};
+
+enum class Shape
+{
+    // One long dependency chain, every step also reading a shared source
+    Chain,
+    // Many leaves reduced pairwise down to one value
+    FanIn,
+    // Columns of nodes each reading two random nodes from earlier columns
+    Layered,
+};
+
+inline constexpr std::array<std::pair<Shape, std::string_view>, 3> shapeNames{{
+    {Shape::Chain, "chain"},
+    {Shape::FanIn, "fanin"},
+    {Shape::Layered, "layered"},
+}};
+
+inline std::string_view toString(Shape shape)
+{
+    for (const auto& [value, name] : shapeNames)
+    {
+        if (value == shape)
+        {
+            return name;
+        }
+    }
+
+    return {};
+}
+
+inline std::optional<Shape> shapeFromString(std::string_view name)
+{
+    for (const auto& [value, name_] : shapeNames)
+    {
+        if (name_ == name)
+        {
+            return value;
+        }
+    }
+
+    return std::nullopt;
+}
+
+struct Options
+{
+    Shape shape = Shape::Chain;
+
+    // Roughly how many nodes the graph ends up with
+    int size = 1000;
+
+    std::uint32_t seed = 1;
+};
+
+class Builder
+{
+public:
+    Builder(Graph& graph, std::uint32_t seed) : graph{graph}, random{seed}
+    {
+    }
+
+    // Nodes are laid out in columns, one per step away from the sources
+    NodeId add(int column)
+    {
+        auto& node = graph.AddNode(Graph::makeNode<Node>(graph.nodeArena));
+
+        if (column >= static_cast<int>(columnHeights.size()))
+        {
+            columnHeights.resize(column + 1);
+        }
+
+        node.setPosition({column * 250.f, columnHeights[column]});
+        columnHeights[column] += 120.f;
+
+        return node.id;
+    }
+
+    void link(NodeId from, NodeId to, PinId::PinIndex input)
+    {
+        graph.addLink(PinId::makeOutput(from, 0), PinId::makeInput(to, input));
+    }
+
+    Graph& graph;
+    std::mt19937 random;
+
+    std::vector<float> columnHeights;
+};
+
+inline void generateChain(Builder& builder, int size)
+{
+    const auto source = builder.add(0);
+    auto previous = builder.add(0);
+
+    for (int x = 0; x < size; x++)
+    {
+        const auto node = builder.add(x + 1);
+        builder.link(previous, node, 0);
+        builder.link(source, node, 1);
+        previous = node;
+    }
+}
+
+inline void generateFanIn(Builder& builder, int size)
+{
+    std::vector<NodeId> level;
+    for (int x = 0; x < std::max(size / 2, 2); x++)
+    {
+        level.push_back(builder.add(0));
+    }
+
+    int column = 1;
+    while (level.size() > 1)
+    {
+        std::vector<NodeId> next;
+        for (std::size_t x = 0; x + 1 < level.size(); x += 2)
+        {
+            const auto node = builder.add(column);
+            builder.link(level[x], node, 0);
+            builder.link(level[x + 1], node, 1);
+            next.push_back(node);
+        }
+
+        if (level.size() % 2 == 1)
+        {
+            next.push_back(level.back());
+        }
+
+        level = std::move(next);
+        column++;
+    }
+}
+
+inline void generateLayered(Builder& builder, int size)
+{
+    static constexpr int columnSize = 32;
+
+    std::vector<NodeId> created;
+    for (int x = 0; x < std::max(size, columnSize + 1); x++)
+    {
+        const int column = x / columnSize;
+        const auto node = builder.add(column);
+
+        // Anything from an earlier column, so the links never close a cycle
+        if (column > 0)
+        {
+            std::uniform_int_distribution<std::size_t> pick{0, static_cast<std::size_t>(column) * columnSize - 1};
+            builder.link(created[pick(builder.random)], node, 0);
+            builder.link(created[pick(builder.random)], node, 1);
+        }
+
+        created.push_back(node);
+    }
+}
+
+inline void generate(Graph& graph, const Options& options)
+{
+    Builder builder{graph, options.seed};
+
+    switch (options.shape)
+    {
+    case Shape::Chain:
+        generateChain(builder, options.size);
+        break;
+    case Shape::FanIn:
+        generateFanIn(builder, options.size);
+        break;
+    case Shape::Layered:
+        generateLayered(builder, options.size);
+        break;
+    }
+}
+
+} // namespace GraphGenerator
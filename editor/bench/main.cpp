@@ -0,0 +1,797 @@
+// Headless benchmarks of the editor's graph, archetype search and codecs on generated data. Prints a JSON report,
+// see --help. Builds without ImGui, so nothing that draws or needs the material nodes is timed here.
+
+#include "graph-generator.hpp"
+#include "mls/base64.hpp"
+#include "mls/serializer.hpp"
+#include "nodes/archetype-search.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::vector<int> sizes{100, 1000, 10000};
+    std::vector<GraphGenerator::Shape> shapes{
+        GraphGenerator::Shape::Chain, GraphGenerator::Shape::FanIn, GraphGenerator::Shape::Layered};
+    int iterations = 5;
+
+    // Only benchmarks whose name contains it run
+    std::string filter;
+
+    // Standard output when empty
+    std::string out;
+
+    bool help{};
+};
+
+struct Fixture
+{
+    Graph graph;
+
+    std::size_t nodeCount() const
+    {
+        return graph.nodes.size();
+    }
+};
+
+struct Result
+{
+    std::string benchmark;
+    std::string shape;
+    std::size_t nodes{};
+    std::size_t links{};
+
+    // Processed by each iteration, for throughput benchmarks
+    std::size_t bytes{};
+
+    // Milliseconds, one per iteration
+    std::vector<double> samples;
+};
+
+class Runner
+{
+public:
+    explicit Runner(const Options& options) : options{options}
+    {
+    }
+
+    // setup runs before every iteration and isn't timed
+    void measure(std::string_view benchmark,
+                 std::string_view shape,
+                 const std::unique_ptr<Fixture>& fixture,
+                 const std::function<void()>& setup,
+                 const std::function<void()>& run,
+                 std::size_t bytes = 0)
+    {
+        if (!enabled(benchmark))
+        {
+            return;
+        }
+
+        Result result{std::string(benchmark), std::string(shape)};
+        result.bytes = bytes;
+
+        for (int x = 0; x < options.iterations; x++)
+        {
+            setup();
+
+            const auto start = Clock::now();
+            run();
+            const auto end = Clock::now();
+
+            result.samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        // Counted afterwards, generate builds the graph it is given
+        if (fixture)
+        {
+            result.nodes = fixture->nodeCount();
+            result.links = fixture->graph.links.size();
+        }
+
+        report(result);
+        results.push_back(std::move(result));
+    }
+
+    bool enabled(std::string_view benchmark) const
+    {
+        return options.filter.empty() || benchmark.contains(options.filter);
+    }
+
+    // A benchmark whose result came out wrong, the report is still written but the run fails
+    void expect(bool condition, std::string_view what)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << what << '\n';
+            failed = true;
+        }
+    }
+
+    bool hasFailed() const
+    {
+        return failed;
+    }
+
+    static std::unique_ptr<Fixture> makeFixture(GraphGenerator::Shape shape, int size)
+    {
+        auto fixture = std::make_unique<Fixture>();
+        GraphGenerator::generate(fixture->graph, {shape, size});
+        return fixture;
+    }
+
+    void runShape(GraphGenerator::Shape shape, int size)
+    {
+        const auto shapeName = GraphGenerator::toString(shape);
+        std::mt19937 random{static_cast<std::uint32_t>(size)};
+
+        std::unique_ptr<Fixture> fresh;
+        measure(
+            "generate",
+            shapeName,
+            fresh,
+            [&] { fresh = std::make_unique<Fixture>(); },
+            [&] { GraphGenerator::generate(fresh->graph, {shape, size}); });
+
+        fresh.reset();
+
+        const auto fixture = makeFixture(shape, size);
+        auto& graph = fixture->graph;
+
+        const auto pickLinks = [&](std::size_t count)
+        {
+            std::vector<LinkId> picked;
+            std::ranges::sample(graph.links, std::back_inserter(picked), count, random);
+            return picked;
+        };
+
+        const auto linksBefore = graph.links;
+
+        std::vector<LinkId> mutated;
+        measure(
+            "graph_relink",
+            shapeName,
+            fixture,
+            [&] { mutated = pickLinks(std::max<std::size_t>(graph.links.size() / 10, 1)); },
+            [&]
+            {
+                for (const auto link : mutated)
+                {
+                    graph.removeLink(link);
+                }
+
+                for (const auto link : mutated)
+                {
+                    graph.addLink(link.from(), link.to());
+                }
+            });
+
+        expect(graph.links == linksBefore, "graph_relink didn't restore the links it removed");
+
+        std::string saved;
+        measure(
+            "links_save",
+            shapeName,
+            fixture,
+            [] {},
+            [&]
+            {
+                json j;
+                Serializer s(true, j);
+                s.serialize("links", graph.links);
+                saved = j.dump();
+            });
+
+        if (saved.empty())
+        {
+            json j;
+            Serializer s(true, j);
+            s.serialize("links", graph.links);
+            saved = j.dump();
+        }
+
+        // Into the same nodes without their links, then indexed again like GraphEditor does after loading
+        measure(
+            "links_load",
+            shapeName,
+            fresh,
+            [&]
+            {
+                fresh = makeFixture(shape, size);
+                fresh->graph.links.clear();
+                fresh->graph.rebuildLinkIndex();
+            },
+            [&]
+            {
+                auto j = json::parse(saved);
+                Serializer s(false, j);
+                s.serialize("links", fresh->graph.links);
+                fresh->graph.rebuildLinkIndex();
+            });
+
+        if (fresh)
+        {
+            expect(fresh->graph.links == graph.links, "links_load didn't read back the saved links");
+        }
+
+        fresh.reset();
+
+        // Deleting 1k nodes with their links, or half the graph when it is smaller
+        std::unique_ptr<Fixture> deleting;
+        std::vector<NodeId> deleted;
+        std::size_t nodesBefore = 0;
+        measure(
+            "graph_delete",
+            shapeName,
+            deleting,
+            [&]
+            {
+                deleting = makeFixture(shape, size);
+                nodesBefore = deleting->nodeCount();
+
+                std::vector<NodeId> ids;
+                for (const auto& node : deleting->graph.nodes)
+                {
+                    ids.push_back(node->id);
+                }
+
+                deleted.clear();
+                const auto count = std::min<std::size_t>(1000, ids.size() / 2);
+                std::ranges::sample(ids, std::back_inserter(deleted), count, random);
+            },
+            [&]
+            {
+                for (const auto id : deleted)
+                {
+                    deleting->graph.removeNode(id);
+                }
+            });
+
+        if (deleting)
+        {
+            const std::unordered_set<NodeId> gone{deleted.begin(), deleted.end()};
+            const auto dangling = std::ranges::any_of(deleting->graph.links,
+                                                      [&](LinkId link)
+                                                      {
+                                                          return gone.contains(link.from().nodeId()) ||
+                                                                 gone.contains(link.to().nodeId());
+                                                      });
+
+            expect(deleting->nodeCount() + deleted.size() == nodesBefore && !dangling,
+                   "graph_delete left deleted nodes or their links behind");
+        }
+    }
+
+    // What a frame reads from a 5k node graph: every node, its links and the node at the other end of each.
+    // Drawing them needs ImGui and the node editor, which this build leaves out.
+    void runFrameReads(GraphGenerator::Shape shape)
+    {
+        static constexpr int Size = 5'000;
+
+        static constexpr std::array<std::string_view, 2> benchmarks{"frame_reads_idle", "frame_reads_relink"};
+        if (std::ranges::none_of(benchmarks, [&](std::string_view name) { return enabled(name); }))
+        {
+            return;
+        }
+
+        const auto shapeName = GraphGenerator::toString(shape);
+        std::mt19937 random{Size};
+
+        const auto fixture = makeFixture(shape, Size);
+        auto& graph = fixture->graph;
+
+        std::size_t visitedLinks = 0;
+        float extent = 0.f;
+        const auto frame = [&]
+        {
+            visitedLinks = 0;
+            for (const auto& node : graph.nodes)
+            {
+                for (const auto link : graph.getLinks(node->id))
+                {
+                    const auto other = link.from().nodeId() == node->id ? link.to().nodeId() : link.from().nodeId();
+                    const auto& otherNode = graph.getNode<Graph::Node>(other);
+                    extent = std::max(extent, otherNode.position.x - node->position.x);
+                    visitedLinks++;
+                }
+            }
+        };
+
+        measure("frame_reads_idle", shapeName, fixture, [] {}, frame);
+
+        // A link moved before the frame, what dragging a wire costs
+        measure(
+            "frame_reads_relink",
+            shapeName,
+            fixture,
+            [&]
+            {
+                std::vector<LinkId> picked;
+                std::ranges::sample(graph.links, std::back_inserter(picked), 1, random);
+                graph.removeLink(picked.front());
+                graph.addLink(picked.front().from(), picked.front().to());
+            },
+            frame);
+
+        expect(visitedLinks == 2 * graph.links.size() && extent > 0.f, "frame_reads didn't reach every link");
+    }
+
+    // A chain 100k nodes deep: linking it, links that would close a cycle over it and collecting what its end reads
+    void runDeepChain()
+    {
+        static constexpr std::size_t Depth = 100'000;
+
+        static constexpr std::array<std::string_view, 3> benchmarks{
+            "deep_chain_link", "deep_chain_cycle", "deep_chain_upstream"};
+        if (std::ranges::none_of(benchmarks, [&](std::string_view name) { return enabled(name); }))
+        {
+            return;
+        }
+
+        std::unique_ptr<Fixture> fixture;
+        std::vector<NodeId> chain;
+        NodeId source{0};
+
+        const auto addNodes = [&]
+        {
+            fixture = std::make_unique<Fixture>();
+            GraphGenerator::Builder builder{fixture->graph, 1};
+
+            source = builder.add(0);
+
+            chain.clear();
+            chain.push_back(builder.add(0));
+            for (std::size_t x = 0; x < Depth; x++)
+            {
+                chain.push_back(builder.add(static_cast<int>(x) + 1));
+            }
+        };
+
+        const auto linkChain = [&]
+        {
+            GraphGenerator::Builder builder{fixture->graph, 1};
+            for (std::size_t x = 1; x < chain.size(); x++)
+            {
+                builder.link(chain[x - 1], chain[x], 0);
+                builder.link(source, chain[x], 1);
+            }
+        };
+
+        measure("deep_chain_link", "chain", fixture, addNodes, linkChain);
+
+        if (!fixture || fixture->graph.links.empty())
+        {
+            addNodes();
+            linkChain();
+        }
+
+        auto& graph = fixture->graph;
+
+        const auto linkCount = graph.links.size();
+        expect(linkCount == 2 * Depth, "deep_chain_link didn't link the whole chain");
+
+        // From the end of the chain back into it, every one of them has to be refused
+        std::vector<NodeId> targets;
+        for (std::size_t x = 0; x < chain.size(); x += chain.size() / 100)
+        {
+            targets.push_back(chain[x]);
+        }
+
+        std::size_t accepted = 0;
+        measure(
+            "deep_chain_cycle",
+            "chain",
+            fixture,
+            [&] { accepted = 0; },
+            [&]
+            {
+                for (const auto target : targets)
+                {
+                    accepted += graph.addLink(PinId::makeOutput(chain.back(), 0), PinId::makeInput(target, 0));
+                }
+            });
+
+        expect(accepted == 0 && graph.links.size() == linkCount, "deep_chain_cycle accepted a link closing a cycle");
+
+        // The walk code generation does from an output, without recursing
+        std::vector<NodeId> upstream;
+        measure(
+            "deep_chain_upstream",
+            "chain",
+            fixture,
+            [] {},
+            [&] { upstream = graph.collectUpstream(chain.back(), [](NodeId) { return false; }); });
+
+        if (enabled("deep_chain_upstream"))
+        {
+            // The whole chain and the source it reads at every step
+            expect(upstream.size() == chain.size() + 1, "deep_chain_upstream missed part of the chain");
+        }
+    }
+
+    // 2,000 made up archetypes, each query typed and then erased one character at a time like in the popup.
+    // Every step of the cached search is checked against a full rescan by a fresh index.
+    void runSyntheticArchetypeSearch()
+    {
+        if (!enabled("archetype_search_2k"))
+        {
+            return;
+        }
+
+        static constexpr std::array categories{"Math", "Vector", "Texture", "Noise", "Color", "Utility", "Lighting"};
+        static constexpr std::array words{"Add",    "Blend",   "Clamp",   "Cross",  "Distance", "Dot",      "Fresnel",
+                                          "Hash",   "Lerp",    "Noise",   "Normal", "Offset",   "Perlin",   "Radial",
+                                          "Remap",  "Rotate",  "Sample",  "Scale",  "Sine",     "Saturate", "Smooth",
+                                          "Step",   "Swizzle", "Tangent", "Warp",   "World",    "Voronoi",  "Gradient"};
+
+        std::vector<NodeArchetype> synthetic(2'000);
+        for (std::size_t x = 0; x < synthetic.size(); x++)
+        {
+            const std::string_view first = words[x % words.size()];
+            const std::string_view second = words[x / words.size() % words.size()];
+
+            auto& archetype = synthetic[x];
+            archetype.category = categories[x % categories.size()];
+            archetype.title = std::format("{} {} {}", first, second, x);
+            archetype.id = std::format("{}_{}_{}", first, second, x);
+            std::ranges::transform(archetype.id, archetype.id.begin(), [](unsigned char c) { return std::tolower(c); });
+        }
+
+        const auto makeSearch = [&]
+        {
+            ArchetypeSearch search;
+            for (const auto& archetype : synthetic)
+            {
+                search.add(archetype);
+            }
+
+            // A few favourites, so the usage boost takes part in the ranking
+            for (std::size_t x = 0; x < synthetic.size(); x += 97)
+            {
+                for (std::size_t use = 0; use < x % 5 + 1; use++)
+                {
+                    search.recordUse(synthetic[x]);
+                }
+            }
+
+            return search;
+        };
+
+        static constexpr std::array queries{
+            "add", "smooth step", "smst", "vrn", "rotate 12", "perlin noise", "nrm wrld", "math blend", "xyz"};
+
+        const auto typeQueries = [&](const std::function<void(std::string_view)>& find)
+        {
+            for (const std::string_view query : queries)
+            {
+                for (std::size_t length = 0; length <= query.size(); length++)
+                {
+                    find(query.substr(0, length));
+                }
+
+                for (std::size_t length = query.size(); length-- > 0;)
+                {
+                    find(query.substr(0, length));
+                }
+            }
+        };
+
+        auto search = makeSearch();
+        measure(
+            "archetype_search_2k",
+            "",
+            noFixture,
+            [] {},
+            [&] { typeQueries([&](std::string_view query) { search.find(query); }); });
+
+        const auto sameResult = [](const ArchetypeSearch::Result& a, const ArchetypeSearch::Result& b)
+        { return a.archetype == b.archetype && a.score == b.score; };
+
+        auto incremental = makeSearch();
+        std::size_t mismatches = 0;
+        std::size_t matched = 0;
+
+        typeQueries(
+            [&](std::string_view query)
+            {
+                auto rescan = makeSearch();
+                const auto expected = rescan.find(query);
+                const auto found = incremental.find(query);
+
+                mismatches += !std::ranges::equal(found, expected, sameResult);
+                matched += found.size();
+            });
+
+        expect(mismatches == 0,
+               std::format("archetype_search_2k differs from a full rescan on {} queries", mismatches));
+        expect(matched > 0, "archetype_search_2k matched nothing");
+    }
+
+    // Texture data is embedded in materials as base64, timed on every kernel the CPU has
+    void runBase64()
+    {
+        using base64::detail::Isa;
+
+        std::mt19937 random{64};
+        std::string data(16 * 1024 * 1024, '\0');
+        std::ranges::generate(data, [&] { return static_cast<char>(random()); });
+
+        const auto expected = base64::to_base64(data);
+
+        static constexpr std::array<std::pair<Isa, std::string_view>, 3> kernels{
+            {{Isa::Scalar, "scalar"}, {Isa::Sse41, "sse41"}, {Isa::Avx2, "avx2"}}};
+
+        for (const auto& [isa, name] : kernels)
+        {
+            if (isa > base64::detail::detect_isa())
+            {
+                continue;
+            }
+
+            base64::set_max_isa(isa);
+
+            std::string encoded;
+            measure("base64_encode", name, noFixture, [] {}, [&] { encoded = base64::to_base64(data); }, data.size());
+
+            std::string decoded;
+            measure(
+                "base64_decode", name, noFixture, [] {}, [&] { decoded = base64::from_base64(expected); }, data.size());
+
+            if (enabled("base64_encode"))
+            {
+                expect(encoded == expected, std::format("base64_encode {} differs from the default kernel", name));
+            }
+
+            if (enabled("base64_decode"))
+            {
+                expect(decoded == data, std::format("base64_decode {} doesn't round trip", name));
+            }
+        }
+
+        base64::set_max_isa(base64::detail::detect_isa());
+    }
+
+    json toJson() const
+    {
+        json report;
+        report["version"] = 1;
+        report["iterations"] = options.iterations;
+
+        auto& entries = report["results"] = json::array();
+        for (const auto& result : results)
+        {
+            auto sorted = result.samples;
+            std::ranges::sort(sorted);
+
+            json entry{
+                {"benchmark", result.benchmark},
+                {"shape", result.shape},
+                {"nodes", result.nodes},
+                {"links", result.links},
+                {"min_ms", sorted.front()},
+                {"median_ms", sorted[sorted.size() / 2]},
+                {"mean_ms", std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size()},
+                {"max_ms", sorted.back()},
+            };
+
+            if (result.bytes)
+            {
+                entry["bytes"] = result.bytes;
+                entry["median_gb_per_s"] = gigabytesPerSecond(result.bytes, sorted[sorted.size() / 2]);
+            }
+
+            entries.push_back(std::move(entry));
+        }
+
+        return report;
+    }
+
+private:
+    const Options& options;
+
+    std::vector<Result> results;
+    bool failed{};
+
+    const std::unique_ptr<Fixture> noFixture;
+
+    static double gigabytesPerSecond(std::size_t bytes, double milliseconds)
+    {
+        return bytes / (milliseconds * 1e6);
+    }
+
+    static void report(const Result& result)
+    {
+        const auto median = [&]
+        {
+            auto sorted = result.samples;
+            std::ranges::sort(sorted);
+            return sorted[sorted.size() / 2];
+        }();
+
+        if (result.bytes)
+        {
+            std::cerr << std::format("{:<28}{:<8}{:>8.2f} GB/s{:>10.3f} ms\n",
+                                     result.benchmark,
+                                     result.shape,
+                                     gigabytesPerSecond(result.bytes, median),
+                                     median);
+            return;
+        }
+
+        std::cerr << std::format("{:<28}{:<8}{:>8} nodes{:>10.3f} ms\n", result.benchmark, result.shape, result.nodes, median);
+    }
+};
+
+template <typename T, typename Parse>
+bool parseList(std::string_view text, std::vector<T>& out, Parse parse)
+{
+    out.clear();
+
+    for (const auto part : std::views::split(text, ','))
+    {
+        if (auto value = parse(std::string_view(part.begin(), part.end())))
+        {
+            out.push_back(*value);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return !out.empty();
+}
+
+std::optional<int> parseInt(std::string_view text)
+{
+    int value{};
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc{} || end != text.data() + text.size() || value <= 0)
+    {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+constexpr std::string_view usage = R"(Usage: MLSE_bench [options]
+  --sizes 100,1000,10000        Approximate node counts of the generated graphs
+  --shapes chain,fanin,layered
+  --iterations 5                Timed runs of each benchmark
+  --filter name                 Only run benchmarks whose name contains it
+  --out report.json             Write the report there instead of standard output
+  --help                        Print this and exit
+)";
+
+std::optional<Options> parseOptions(int argc, char** argv)
+{
+    Options options;
+
+    for (int x = 1; x < argc; x++)
+    {
+        const std::string_view arg = argv[x];
+        if (arg == "--help")
+        {
+            options.help = true;
+            continue;
+        }
+
+        if (x + 1 >= argc)
+        {
+            return std::nullopt;
+        }
+
+        const std::string_view value = argv[++x];
+
+        bool valid = true;
+        if (arg == "--sizes")
+        {
+            valid = parseList(value, options.sizes, parseInt);
+        }
+        else if (arg == "--shapes")
+        {
+            valid = parseList(value, options.shapes, GraphGenerator::shapeFromString);
+        }
+        else if (arg == "--iterations")
+        {
+            const auto iterations = parseInt(value);
+            valid = iterations.has_value();
+            options.iterations = iterations.value_or(0);
+        }
+        else if (arg == "--filter")
+        {
+            options.filter = value;
+        }
+        else if (arg == "--out")
+        {
+            options.out = value;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            return std::nullopt;
+        }
+    }
+
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto options = parseOptions(argc, argv);
+    if (!options)
+    {
+        std::cerr << usage;
+        return 1;
+    }
+
+    if (options->help)
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    Runner runner{*options};
+
+    for (const auto shape : options->shapes)
+    {
+        for (const auto size : options->sizes)
+        {
+            runner.runShape(shape, size);
+        }
+
+        runner.runFrameReads(shape);
+    }
+
+    runner.runDeepChain();
+    runner.runSyntheticArchetypeSearch();
+    runner.runBase64();
+
+    const auto report = runner.toJson().dump(2);
+    if (options->out.empty())
+    {
+        std::cout << report << '\n';
+    }
+    else
+    {
+        std::ofstream file{options->out};
+        file << report << '\n';
+
+        if (!file)
+        {
+            std::cerr << "Failed to write " << options->out << '\n';
+            return 1;
+        }
+    }
+
+    return runner.hasFailed() ? 1 : 0;
+}
@@ -1077,6 +1077,7 @@ ed::EditorContext::EditorContext(const ax::NodeEditor::Config* config)
     , m_ShortcutsEnabled(true)
     , m_Style()
     , m_Nodes()
+    , m_NodeIndex()
     , m_Pins()
     , m_Links()
     , m_SelectionId(1)
@@ -1165,6 +1166,11 @@ void ed::EditorContext::Begin(const char* id, const ImVec2& size)
         }), objects.end());
     };
 
+    m_NodeIndex.erase(std::remove_if(m_NodeIndex.begin(), m_NodeIndex.end(), [](auto objectWrapper)
+    {
+        return objectWrapper->m_DeleteOnNewFrame;
+    }), m_NodeIndex.end());
+
     resetAndCollect(m_Nodes);
     resetAndCollect(m_Pins);
     resetAndCollect(m_Links);
@@ -2053,7 +2059,9 @@ ed::Node* ed::EditorContext::CreateNode(NodeId id)
     IM_ASSERT(nullptr == FindObject(id));
     auto node = new Node(this, id);
     m_Nodes.push_back({id, node});
-    //std::sort(Nodes.begin(), Nodes.end());
+
+    ObjectWrapper<Node> indexEntry{id, node};
+    m_NodeIndex.insert(std::upper_bound(m_NodeIndex.begin(), m_NodeIndex.end(), indexEntry), indexEntry);
 
     auto settings = m_Settings.FindNode(id);
     if (!settings)
@@ -2123,7 +2131,7 @@ static inline auto FindItemIn(C& container, Id id)
 
 ed::Node* ed::EditorContext::FindNode(NodeId id)
 {
-    return FindItemInLinear(m_Nodes, id);
+    return FindItemIn(m_NodeIndex, id);
 }
 
 ed::Pin* ed::EditorContext::FindPin(PinId id)
@@ -2774,17 +2782,22 @@ bool ed::NodeSettings::Parse(const json::value& data, NodeSettings& result)
 // Settings
 //
 //------------------------------------------------------------------------------
+static inline bool NodeSettingsIdLess(const ed::NodeSettings& settings, ed::NodeId id)
+{
+    return settings.m_ID.AsPointer() < id.AsPointer();
+}
+
 ed::NodeSettings* ed::Settings::AddNode(NodeId id)
 {
-    m_Nodes.push_back(NodeSettings(id));
-    return &m_Nodes.back();
+    auto it = std::lower_bound(m_Nodes.begin(), m_Nodes.end(), id, NodeSettingsIdLess);
+    return &*m_Nodes.insert(it, NodeSettings(id));
 }
 
 ed::NodeSettings* ed::Settings::FindNode(NodeId id)
 {
-    for (auto& settings : m_Nodes)
-        if (settings.m_ID == id)
-            return &settings;
+    auto it = std::lower_bound(m_Nodes.begin(), m_Nodes.end(), id, NodeSettingsIdLess);
+    if (it != m_Nodes.end() && it->m_ID == id)
+        return &*it;
 
     return nullptr;
 }
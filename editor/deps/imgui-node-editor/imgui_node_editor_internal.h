@@ -529,7 +529,7 @@ struct Settings
     bool                 m_IsDirty;
     SaveReasonFlags      m_DirtyReason;
 
-    vector<NodeSettings> m_Nodes;
+    vector<NodeSettings> m_Nodes; // sorted by id
     vector<ObjectId>     m_Selection;
     ImVec2               m_ViewScroll;
     float                m_ViewZoom;
@@ -1316,6 +1316,8 @@ struct EditorContext
 
     EditorAction* GetCurrentAction() { return m_CurrentAction; }
 
+    bool HasLiveAnimations() const { return !m_LiveAnimations.empty(); }
+
     CreateItemAction& GetItemCreator() { return m_CreateItemAction; }
     DeleteItemsAction& GetItemDeleter() { return m_DeleteItemsAction; }
     ContextMenuAction& GetContextMenu() { return m_ContextMenuAction; }
@@ -1510,6 +1512,7 @@ private:
     Style               m_Style;
 
     vector<ObjectWrapper<Node>> m_Nodes;
+    vector<ObjectWrapper<Node>> m_NodeIndex; // m_Nodes sorted by id, m_Nodes itself is kept in draw order
     vector<ObjectWrapper<Pin>>  m_Pins;
     vector<ObjectWrapper<Link>> m_Links;
 
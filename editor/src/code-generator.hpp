@@ -1,13 +1,19 @@
 #pragma once
 
+#include "constant-folding.hpp"
 #include "graph.hpp"
 #include "nodes/expression.hpp"
 #include "value.hpp"
 #include "code-function.hpp"
+#include "profiler.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <format>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 struct CodeGenerator
@@ -21,13 +27,71 @@ struct CodeGenerator
     Graph& graph;
     Type type;
 
+    // What a piece of generated code reads, recorded as it is emitted so eliminateDeadCode never parses GLSL
+    struct References
+    {
+        std::vector<std::string> vars;
+        std::vector<std::string> inputs;
+        std::vector<std::string> functions;
+
+        // Custom code may read any uniform by name
+        bool allInputs{};
+
+        void merge(const References& other)
+        {
+            const auto append = [](auto& to, const auto& from)
+            {
+                for (const auto& name : from)
+                {
+                    if (std::ranges::find(to, name) == to.end())
+                    {
+                        to.push_back(name);
+                    }
+                }
+            };
+
+            append(vars, other.vars);
+            append(inputs, other.inputs);
+            append(functions, other.functions);
+            allInputs |= other.allInputs;
+        }
+    };
+
+    struct Statement
+    {
+        std::string code;
+
+        // Variables the statement writes, one writing none writes a shader output and is always kept
+        std::vector<std::string> defines;
+
+        References uses;
+
+        // Set on a variable only declared so an equal expression emitted later can share it. If none did, the
+        // expression goes back in place of the variable.
+        std::string inlineExpression;
+    };
+
     std::unordered_map<std::string, ValueType> shaderInputs;
     std::unordered_map<std::string, CodeGen::Function> functions;
-    std::vector<std::string> body;
+    std::vector<Statement> body;
 
     std::unordered_map<PinId, Value> cachedValues;
+
+    // What the value of each output pin reads, a hoisted one only reads its variable
+    std::unordered_map<PinId, References> pinReferences;
+
+    // Everything read by the inputs of the node being evaluated and by the code it emitted so far
+    References nodeReferences;
+
+    std::unordered_set<NodeId> evaluatedNodes;
     std::vector<std::string> usedFunctions;
 
+    // Hoisted expressions by type and code, the same expression anywhere in the graph reuses the first variable
+    std::unordered_map<std::string, Value> sharedVars;
+
+    // Shorter expressions read by a single pin stay inline, unless they turn out to repeat
+    static constexpr std::size_t ExpressionVariableLengthCutoff = 15;
+
     int nextVar = 0;
 
     const void evaluate(NodeId nodeId)
@@ -36,12 +100,41 @@ struct CodeGenerator
         evaluate(node);
     }
 
-    const void evaluate(ExpressionNode& node)
+    // Evaluates everything upstream of root that isn't evaluated yet, producers first
+    const void evaluate(ExpressionNode& root)
+    {
+        PROFILE_SCOPE("CodeGenerator::evaluate");
+
+        const auto upstream = graph.collectUpstream(root.id, [&](NodeId id) { return evaluatedNodes.contains(id); });
+
+        for (const auto id : upstream)
+        {
+            if (evaluatedNodes.insert(id).second)
+            {
+                evaluateNode(graph.getNode<ExpressionNode>(id));
+            }
+        }
+    }
+
+    // Producers of the node's inputs must already be evaluated
+    void evaluateNode(ExpressionNode& node)
     {
+        node.resetEvaluation();
+        nodeReferences = {};
+
         for (uint8_t inputIndex = 0; inputIndex < node.inputs.size(); inputIndex++)
         {
             auto& input = node.inputs.at(inputIndex);
-            input.value = evaluate(node.id.makeInput(inputIndex));
+            const auto pin = node.id.makeInput(inputIndex);
+            input.value = evaluate(pin);
+
+            if (const auto link = graph.findLink(pin))
+            {
+                if (const auto it = pinReferences.find(link.from()); it != pinReferences.end())
+                {
+                    nodeReferences.merge(it->second);
+                }
+            }
         }
 
         const auto& archetype = *node.archetype;
@@ -167,8 +260,6 @@ struct CodeGenerator
 
         node.evaluate(*this);
 
-        constexpr size_t ExpressionVariableLengthCutoff = 15;
-
         for (uint8_t outputIndex = 0; outputIndex < node.outputs.size(); outputIndex++)
         {
             const auto& output = node.outputs.at(outputIndex);
@@ -178,21 +269,28 @@ struct CodeGenerator
                 continue;
             }
 
+            // A non-trivial expression gets a variable the first time it is emitted, so a repeat of it shares the
+            // variable instead of being evaluated again. The variable is only kept for expressions read by several
+            // pins, long ones, or ones that did repeat, see inlineSingleUseVars. Constants stay literals, they cost
+            // nothing and the nodes reading them can fold them further.
             if (output.value)
             {
-                if (output.value.type != Types::texture &&
-                    (output.linkCount > 1 || output.value.code.size() >= ExpressionVariableLengthCutoff))
+                if (output.value.type != Types::texture && !output.value.constant && !isTrivial(output.value.code))
                 {
-                    setAsVar(node.id.makeOutput(outputIndex), output.value);
+                    const bool inlinable =
+                        output.linkCount == 1 && output.value.code.size() < ExpressionVariableLengthCutoff;
+                    setAsVar(node.id.makeOutput(outputIndex), output.value, inlinable);
                 }
                 else
                 {
                     cachedValues[node.id.makeOutput(outputIndex)] = output.value;
+                    pinReferences[node.id.makeOutput(outputIndex)] = nodeReferences;
                 }
             }
         }
     }
 
+    // Value produced for an output pin, or flowing into an input pin, null until its node has been evaluated
     const Value& evaluate(PinId pin)
     {
         if (pin.direction() == PinDirection::In)
@@ -221,23 +319,10 @@ struct CodeGenerator
             }
         }
 
+        const auto it = cachedValues.find(pin);
+        if (it != cachedValues.end())
         {
-            const auto it = cachedValues.find(pin);
-            if (it != cachedValues.end())
-            {
-                return it->second;
-            }
-        }
-
-        const auto nodeId = pin.nodeId();
-        evaluate(nodeId);
-
-        {
-            const auto it = cachedValues.find(pin);
-            if (it != cachedValues.end())
-            {
-                return it->second;
-            }
+            return it->second;
         }
 
         return Values::null;
@@ -248,25 +333,80 @@ struct CodeGenerator
         cachedValues[pin] = std::move(value);
     }
 
-    void setAsVar(PinId pin, const Value& value)
+    // Unlike addVar the variable isn't added to nodeReferences, the node's other outputs don't read it
+    void setAsVar(PinId pin, const Value& value, bool inlinable = false)
     {
-        cachedValues[pin] = addVar(value);
+        auto var = declareVar(value, inlinable);
+        pinReferences[pin] = {.vars = {var.code}};
+        cachedValues[pin] = std::move(var);
     }
 
-    Value addVar(const Value& value)
+    // Generated code has no side effects outside of statements, so equal expressions always hold equal values
+    static std::string expressionKey(const Value& value)
+    {
+        return value.type.toString() + " " + value.code;
+    }
+
+    // Names, literals and swizzles cost nothing to repeat
+    static bool isTrivial(std::string_view code)
+    {
+        return std::ranges::all_of(code, [](unsigned char c) { return std::isalnum(c) || c == '_' || c == '.'; });
+    }
+
+    Value declareVar(const Value& value, bool inlinable = false)
     {
+        auto key = expressionKey(value);
+        if (const auto it = sharedVars.find(key); it != sharedVars.end())
+        {
+            return it->second;
+        }
+
         std::string varName = "var" + std::to_string(nextVar++);
-        body.push_back(value.type.toString() + " " + varName + " = " + value.code + ";");
-        return {value.type, std::move(varName)};
+        body.push_back({value.type.toString() + " " + varName + " = " + value.code + ";",
+                        {varName},
+                        nodeReferences,
+                        inlinable ? value.code : std::string{}});
+
+        Value var{value.type, std::move(varName), value.constant};
+        sharedVars.emplace(std::move(key), var);
+        return var;
+    }
+
+    Value addVar(const Value& value)
+    {
+        auto var = declareVar(value);
+        nodeReferences.merge({.vars = {var.code}});
+        return var;
     }
 
     Value addEmptyVar(const ValueType& type)
     {
         std::string varName = "var" + std::to_string(nextVar++);
-        body.push_back(type.toString() + " " + varName + ";");
+        body.push_back({type.toString() + " " + varName + ";", {varName}});
+        nodeReferences.merge({.vars = {varName}});
         return {type, std::move(varName)};
     }
 
+    // A uniform read by the node being evaluated
+    Value addInput(const std::string& name, const ValueType& type)
+    {
+        shaderInputs[name] = type;
+        nodeReferences.merge({.inputs = {name}});
+        return {type, name};
+    }
+
+    // For code written by the user, it may read any uniform without going through addInput
+    void useAllInputs()
+    {
+        nodeReferences.allInputs = true;
+    }
+
+    // A statement writing a shader output, it reads whatever the node being evaluated does
+    void addStatement(std::string code)
+    {
+        body.push_back({std::move(code), {}, nodeReferences});
+    }
+
     void addFunc(const CodeGen::Function& function)
     {
         auto it = functions.find(function.id);
@@ -300,6 +440,7 @@ struct CodeGenerator
     {
         addFunc(function);
         useFunc(function);
+        nodeReferences.merge({.functions = {function.id}});
 
         assert(params.size() == function.params.size());
 
@@ -324,13 +465,246 @@ struct CodeGenerator
         }
         else
         {
-            body.push_back(out + ";");
+            // Without a return value the call only matters through its out arguments
+            std::vector<std::string> defines;
+            for (std::size_t x = 0; x < params.size(); x++)
+            {
+                if (function.params[x].isOut)
+                {
+                    defines.push_back(params[x].code);
+                }
+            }
+
+            body.push_back({out + ";", std::move(defines), nodeReferences});
             return {};
         }
     }
 
+    // Drops the statements, functions and uniforms the outputs don't depend on, following what was recorded
+    // while emitting them
+    void eliminateDeadCode()
+    {
+        PROFILE_SCOPE("CodeGenerator::eliminateDeadCode");
+
+        std::unordered_set<std::string_view> liveVars;
+        std::unordered_set<std::string_view> liveInputs;
+        std::unordered_set<std::string_view> liveFunctions;
+        std::vector<std::string_view> pendingFunctions;
+        bool allInputs = false;
+
+        std::vector<bool> liveStatements(body.size());
+
+        // Backwards, every use of a variable comes after the statements writing it
+        for (std::size_t x = body.size(); x-- > 0;)
+        {
+            const auto& statement = body[x];
+
+            const bool live = statement.defines.empty() ||
+                              std::ranges::any_of(statement.defines,
+                                                  [&](const std::string& var) { return liveVars.contains(var); });
+            if (!live)
+            {
+                continue;
+            }
+
+            liveStatements[x] = true;
+
+            const auto& uses = statement.uses;
+            liveVars.insert(uses.vars.begin(), uses.vars.end());
+            liveInputs.insert(uses.inputs.begin(), uses.inputs.end());
+            allInputs |= uses.allInputs;
+
+            for (const auto& id : uses.functions)
+            {
+                if (liveFunctions.insert(id).second)
+                {
+                    pendingFunctions.push_back(id);
+                }
+            }
+        }
+
+        // Then the functions the live ones call
+        while (!pendingFunctions.empty())
+        {
+            const auto& function = functions.at(std::string(pendingFunctions.back()));
+            pendingFunctions.pop_back();
+
+            for (const auto& dependency : function.dependencies)
+            {
+                if (liveFunctions.insert(dependency).second)
+                {
+                    pendingFunctions.push_back(dependency);
+                }
+            }
+        }
+
+        if (!allInputs)
+        {
+            std::erase_if(shaderInputs, [&](const auto& input) { return !liveInputs.contains(input.first); });
+        }
+
+        std::erase_if(usedFunctions, [&](const std::string& id) { return !liveFunctions.contains(id); });
+
+        // Last, the sets above look into the statements
+        std::vector<Statement> liveBody;
+        for (std::size_t x = 0; x < body.size(); x++)
+        {
+            if (liveStatements[x])
+            {
+                liveBody.push_back(std::move(body[x]));
+            }
+        }
+        body = std::move(liveBody);
+
+        inlineSingleUseVars();
+    }
+
+    struct VarName
+    {
+        std::size_t position;
+        std::string_view name;
+    };
+
+    // Generated variable names in the code, in order, e.g. var12 and var3 in "var12.x + var3". Nodes emit no
+    // other names of that form, so this needs no GLSL parsing.
+    static std::vector<VarName> findVars(std::string_view code)
+    {
+        const auto isNameChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+
+        std::vector<VarName> vars;
+        for (std::size_t x = 0; x < code.size();)
+        {
+            if (!isNameChar(code[x]))
+            {
+                x++;
+                continue;
+            }
+
+            const auto start = x;
+            while (x < code.size() && isNameChar(code[x]))
+            {
+                x++;
+            }
+
+            const auto name = code.substr(start, x - start);
+            if (name.size() > 3 && name.starts_with("var") &&
+                std::ranges::all_of(name.substr(3), [](char c) { return c >= '0' && c <= '9'; }))
+            {
+                vars.push_back({start, name});
+            }
+        }
+        return vars;
+    }
+
+    // Whether the expression can be put in place of a variable as is, like a name or a single call
+    static bool needsParentheses(std::string_view code)
+    {
+        if (isTrivial(code))
+        {
+            return false;
+        }
+
+        const auto open = code.find('(');
+        if (open == std::string_view::npos || code.back() != ')' ||
+            !isTrivial(code.substr(0, open)))
+        {
+            return true;
+        }
+
+        // The parenthesis after the name has to be the one closing at the end
+        int depth = 0;
+        for (std::size_t x = open; x < code.size(); x++)
+        {
+            depth += code[x] == '(' ? 1 : code[x] == ')' ? -1 : 0;
+            if (depth == 0)
+            {
+                return x + 1 != code.size();
+            }
+        }
+        return true;
+    }
+
+    // Variables declared only to be shared and read exactly once go back inline into their reader. Backwards, so
+    // when an expression moves into a later statement, the variables it reads are counted where they end up.
+    void inlineSingleUseVars()
+    {
+        struct Use
+        {
+            std::size_t count{};
+            std::size_t reader{};
+        };
+
+        std::unordered_map<std::string, Use> uses;
+        for (std::size_t x = 0; x < body.size(); x++)
+        {
+            const auto& statement = body[x];
+            const auto& code = statement.inlineExpression.empty() ? statement.code : statement.inlineExpression;
+            for (const auto& [position, name] : findVars(code))
+            {
+                auto& use = uses[std::string{name}];
+                use.count++;
+                use.reader = x;
+            }
+        }
+
+        std::vector<bool> inlined(body.size());
+        for (std::size_t x = body.size(); x-- > 0;)
+        {
+            const auto& statement = body[x];
+            if (statement.inlineExpression.empty())
+            {
+                continue;
+            }
+
+            const auto& var = statement.defines.front();
+            const auto it = uses.find(var);
+            if (it == uses.end() || it->second.count != 1)
+            {
+                continue;
+            }
+
+            const auto readerIndex = it->second.reader;
+            auto& reader = body[readerIndex];
+
+            const auto readerVars = findVars(reader.code);
+            const auto found = std::ranges::find(readerVars, std::string_view{var}, &VarName::name);
+            if (found == readerVars.end())
+            {
+                continue;
+            }
+
+            const auto& expression = statement.inlineExpression;
+            reader.code.replace(found->position,
+                                var.size(),
+                                needsParentheses(expression) ? "(" + expression + ")" : expression);
+            reader.uses.merge(statement.uses);
+
+            for (const auto& [position, name] : findVars(expression))
+            {
+                if (auto& use = uses[std::string{name}]; use.reader == x)
+                {
+                    use.reader = readerIndex;
+                }
+            }
+
+            inlined[x] = true;
+        }
+
+        std::vector<Statement> keptBody;
+        for (std::size_t x = 0; x < body.size(); x++)
+        {
+            if (!inlined[x])
+            {
+                keptBody.push_back(std::move(body[x]));
+            }
+        }
+        body = std::move(keptBody);
+    }
+
     std::string finalize() const
     {
+        PROFILE_SCOPE("CodeGenerator::finalize");
+
         std::string code;
 
         code += "#version 120\n\n";
@@ -363,10 +737,10 @@ struct CodeGenerator
         code += "\n";
 
         code += "void main()\n{\n";
-        for (const auto& str : body)
+        for (const auto& statement : body)
         {
             code += "\t";
-            code += str;
+            code += statement.code;
             code += "\n";
         }
         code += "}";
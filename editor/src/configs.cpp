@@ -1,5 +1,7 @@
 #include "configs.hpp"
 
+#include <algorithm>
+
 std::string Configs::getConfigFilePath()
 {
     return (std::filesystem::path{sago::getConfigHome()} / "MLSE" / "mlse_config.json").string();
@@ -53,6 +55,16 @@ void Configs::showMenu()
     {
         ImGui::Checkbox("Auto open last project", &autoLoadLastProject);
 
+        if (ImGui::InputInt("Undo memory per tab (MB)", &undoMemoryBudgetMB))
+        {
+            undoMemoryBudgetMB = std::max(undoMemoryBudgetMB, 1);
+        }
+
+        if (ImGui::InputInt("Animated preview frame cap (0 = vsync)", &animatedFrameCap))
+        {
+            animatedFrameCap = std::max(animatedFrameCap, 0);
+        }
+
         ImGui::NewLine();
 
         if (ImGui::Button("Close"))
@@ -69,4 +81,15 @@ void serialize(Serializer& s, Configs& configs)
 {
     s.serialize("recentProjects", configs.recentProjects);
     s.serialize("autoLoadLastProject", configs.autoLoadLastProject);
+
+    // Older config files don't have these
+    if (s.isSaving || s.j.contains("undoMemoryBudgetMB"))
+    {
+        s.serialize("undoMemoryBudgetMB", configs.undoMemoryBudgetMB);
+    }
+
+    if (s.isSaving || s.j.contains("animatedFrameCap"))
+    {
+        s.serialize("animatedFrameCap", configs.animatedFrameCap);
+    }
 }
\ No newline at end of file
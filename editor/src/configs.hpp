@@ -13,6 +13,10 @@ struct Configs
 {
     std::vector<std::string> recentProjects;
     bool autoLoadLastProject{};
+    int undoMemoryBudgetMB = 64;
+
+    // Frame rate while the preview animates, 0 leaves it to vsync
+    int animatedFrameCap = 60;
 
     bool needOpenMenu{};
 
@@ -0,0 +1,382 @@
+#pragma once
+
+#include "value.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Evaluates operations on values known while generating, so a constant subgraph ends up as a single literal.
+// Nothing is folded where GLSL leaves the result undefined, e.g. a division by zero or the log of a negative,
+// the shader computes those as it did before.
+namespace ConstantFolding
+{
+
+using Components = std::array<float, 4>;
+
+inline std::uint8_t arrityOf(const ValueType& type)
+{
+    const auto* t = std::get_if<GenType>(&type);
+    return t ? t->arrity : 0;
+}
+
+// Shortest text reading back as the same float, with a decimal point so GLSL never sees an int
+inline std::string literal(float value)
+{
+    auto str = std::format("{}", value);
+    if (str.find_first_of(".e") == std::string::npos)
+    {
+        str += ".0";
+    }
+
+    return str;
+}
+
+inline std::optional<Value> makeValue(const ValueType& type, const Components& components)
+{
+    const auto arrity = arrityOf(type);
+    if (arrity == 0)
+    {
+        return std::nullopt;
+    }
+
+    bool uniform = true;
+    for (std::uint8_t x = 0; x < arrity; x++)
+    {
+        if (!std::isfinite(components[x]))
+        {
+            return std::nullopt;
+        }
+
+        uniform &= components[x] == components[0];
+    }
+
+    Value value{type, {}, components};
+
+    if (arrity == 1)
+    {
+        value.code = literal(components[0]);
+    }
+    else if (uniform)
+    {
+        value.code = std::format("{}({})", type.toString(), literal(components[0]));
+    }
+    else
+    {
+        value.code = type.toString() + "(";
+        for (std::uint8_t x = 0; x < arrity; x++)
+        {
+            if (x > 0)
+            {
+                value.code += ", ";
+            }
+
+            value.code += literal(components[x]);
+        }
+        value.code += ")";
+    }
+
+    return value;
+}
+
+// A scalar operand applies to every component, like in GLSL
+inline float component(const Value& value, std::uint8_t index)
+{
+    return (*value.constant)[arrityOf(value.type) == 1 ? 0 : index];
+}
+
+// Whether every argument is a constant matching the arrity, or a scalar
+inline bool foldable(std::span<const Value> args, std::uint8_t arrity)
+{
+    for (const auto& arg : args)
+    {
+        const auto argArrity = arrityOf(arg.type);
+        if (!arg.constant || argArrity == 0 || (argArrity != 1 && argArrity != arrity))
+        {
+            return false;
+        }
+    }
+
+    return arrity > 0;
+}
+
+// op gets the component of every argument, missing ones are 0, and returns nothing when it is undefined
+template <typename Op>
+std::optional<Value> componentWise(const ValueType& type, std::span<const Value> args, Op op)
+{
+    const auto arrity = arrityOf(type);
+    if (args.size() > 3 || !foldable(args, arrity))
+    {
+        return std::nullopt;
+    }
+
+    Components result{};
+    for (std::uint8_t x = 0; x < arrity; x++)
+    {
+        std::array<float, 3> operands{};
+        for (std::size_t y = 0; y < args.size(); y++)
+        {
+            operands[y] = component(args[y], x);
+        }
+
+        const auto folded = op(operands[0], operands[1], operands[2]);
+        if (!folded)
+        {
+            return std::nullopt;
+        }
+
+        result[x] = *folded;
+    }
+
+    return makeValue(type, result);
+}
+
+// Only the arithmetic operators, comparisons give booleans
+inline std::optional<Value> binary(std::string_view op, const ValueType& type, const Value& a, const Value& b)
+{
+    const std::array args{a, b};
+    return componentWise(type,
+                         args,
+                         [&](float x, float y, float) -> std::optional<float>
+                         {
+                             if (op == "+")
+                             {
+                                 return x + y;
+                             }
+                             else if (op == "-")
+                             {
+                                 return x - y;
+                             }
+                             else if (op == "*")
+                             {
+                                 return x * y;
+                             }
+                             else if (op == "/" && y != 0.f)
+                             {
+                                 return x / y;
+                             }
+
+                             return std::nullopt;
+                         });
+}
+
+inline std::optional<float> builtinComponent(std::string_view func, float x, float y, float z)
+{
+    if (func == "abs")
+    {
+        return std::abs(x);
+    }
+    else if (func == "sign")
+    {
+        return float((x > 0.f) - (x < 0.f));
+    }
+    else if (func == "floor")
+    {
+        return std::floor(x);
+    }
+    else if (func == "ceil")
+    {
+        return std::ceil(x);
+    }
+    else if (func == "fract")
+    {
+        return x - std::floor(x);
+    }
+    else if (func == "sqrt" && x >= 0.f)
+    {
+        return std::sqrt(x);
+    }
+    else if (func == "exp")
+    {
+        return std::exp(x);
+    }
+    else if (func == "log" && x > 0.f)
+    {
+        return std::log(x);
+    }
+    else if (func == "log2" && x > 0.f)
+    {
+        return std::log2(x);
+    }
+    else if (func == "sin")
+    {
+        return std::sin(x);
+    }
+    else if (func == "cos")
+    {
+        return std::cos(x);
+    }
+    else if (func == "tan")
+    {
+        return std::tan(x);
+    }
+    else if (func == "asin" && std::abs(x) <= 1.f)
+    {
+        return std::asin(x);
+    }
+    else if (func == "acos" && std::abs(x) <= 1.f)
+    {
+        return std::acos(x);
+    }
+    else if (func == "atan")
+    {
+        return std::atan(x);
+    }
+    else if (func == "min")
+    {
+        return std::min(x, y);
+    }
+    else if (func == "max")
+    {
+        return std::max(x, y);
+    }
+    else if (func == "mod" && y != 0.f)
+    {
+        return x - y * std::floor(x / y);
+    }
+    else if (func == "pow" && (x > 0.f || (x == 0.f && y > 0.f)))
+    {
+        return std::pow(x, y);
+    }
+    else if (func == "clamp" && y <= z)
+    {
+        return std::min(std::max(x, y), z);
+    }
+    else if (func == "mix")
+    {
+        return x * (1.f - z) + y * z;
+    }
+
+    return std::nullopt;
+}
+
+// The builtins working on whole vectors rather than component by component
+inline std::optional<Value> geometric(std::string_view func, const ValueType& type, std::span<const Value> args)
+{
+    const auto arrity = arrityOf(args[0].type);
+    if (args.size() > 2 || !foldable(args, arrity))
+    {
+        return std::nullopt;
+    }
+
+    const auto expand = [&](const Value& value)
+    {
+        Components result{};
+        for (std::uint8_t x = 0; x < arrity; x++)
+        {
+            result[x] = component(value, x);
+        }
+        return result;
+    };
+
+    const auto dot = [&](const Components& a, const Components& b)
+    {
+        float result{};
+        for (std::uint8_t x = 0; x < arrity; x++)
+        {
+            result += a[x] * b[x];
+        }
+        return result;
+    };
+
+    const auto a = expand(args[0]);
+    const auto b = args.size() > 1 ? expand(args[1]) : Components{};
+
+    if (func == "length" && args.size() == 1)
+    {
+        return makeValue(type, {std::sqrt(dot(a, a))});
+    }
+    else if (func == "distance" && args.size() == 2)
+    {
+        Components difference{};
+        for (std::uint8_t x = 0; x < arrity; x++)
+        {
+            difference[x] = a[x] - b[x];
+        }
+
+        return makeValue(type, {std::sqrt(dot(difference, difference))});
+    }
+    else if (func == "dot" && args.size() == 2)
+    {
+        return makeValue(type, {dot(a, b)});
+    }
+    else if (func == "normalize" && args.size() == 1)
+    {
+        const auto length = std::sqrt(dot(a, a));
+        if (length == 0.f)
+        {
+            return std::nullopt;
+        }
+
+        Components result{};
+        for (std::uint8_t x = 0; x < arrity; x++)
+        {
+            result[x] = a[x] / length;
+        }
+
+        return makeValue(type, result);
+    }
+
+    return std::nullopt;
+}
+
+inline std::optional<Value> builtin(std::string_view func, const ValueType& type, std::span<const Value> args)
+{
+    if (args.empty())
+    {
+        return std::nullopt;
+    }
+
+    if (func == "length" || func == "distance" || func == "dot" || func == "normalize")
+    {
+        return geometric(func, type, args);
+    }
+
+    return componentWise(type, args, [&](float x, float y, float z) { return builtinComponent(func, x, y, z); });
+}
+
+// Builds a vector out of constant parts, the way vecN(a, b, ...) does
+inline std::optional<Value> construct(const ValueType& type, std::span<const Value> parts)
+{
+    Components result{};
+    std::uint8_t size{};
+
+    for (const auto& part : parts)
+    {
+        const auto arrity = arrityOf(part.type);
+        if (!part.constant || arrity == 0 || size + arrity > result.size())
+        {
+            return std::nullopt;
+        }
+
+        for (std::uint8_t x = 0; x < arrity; x++)
+        {
+            result[size++] = (*part.constant)[x];
+        }
+    }
+
+    if (size != arrityOf(type))
+    {
+        return std::nullopt;
+    }
+
+    return makeValue(type, result);
+}
+
+inline std::optional<Value> extract(const Value& value, std::uint8_t index)
+{
+    if (!value.constant || index >= arrityOf(value.type))
+    {
+        return std::nullopt;
+    }
+
+    return makeValue(Types::scalar, {(*value.constant)[index]});
+}
+
+} // namespace ConstantFolding
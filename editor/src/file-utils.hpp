@@ -12,6 +12,7 @@ namespace FileUtils
 
 inline const nfdu8filteritem_t defaultImageFilter{"Image File", "bmp,png,tga,jpg,gif,psd,hdr,pic,pnm"};
 inline const nfdu8filteritem_t MlspFilter{"MLS Project", "mlsp"};
+inline const nfdu8filteritem_t TraceFilter{"Chrome Trace", "json"};
 
 inline std::optional<std::string> browseFile(bool save, nfdu8filteritem_t filter)
 {
@@ -3,6 +3,7 @@
 #include "value.hpp"
 
 #include <array>
+#include <atomic>
 #include <string>
 
 #include <cstdint>
@@ -14,13 +15,13 @@ struct FloatField
     bool widthDirty = true;
 
     std::string id;
-    static inline std::size_t nextId{};
+    static inline std::atomic<std::size_t> nextId{};
 
     FloatField()
     {
-        nextId++;
-        id = "##FloatField_";
-        id += std::to_string(nextId);
+        // Short enough to stay within the small string buffer
+        id = "##ff";
+        id += std::to_string(++nextId);
     }
 
     Value toValue() const
@@ -33,7 +34,7 @@ struct FloatField
 
         str += 'f';
 
-        return Value{Types::scalar, str};
+        return Value{Types::scalar, str, std::array<float, 4>{value}};
     }
 
     void update()
@@ -79,13 +80,15 @@ struct ValueField
 
     Value toValue() const
     {
+        const std::array<float, 4> constant{fields[0].value, fields[1].value, fields[2].value, fields[3].value};
+
         if (type == Types::scalar)
         {
             return fields[0].toValue();
         }
         else if (type == Types::vec2)
         {
-            return {type, std::format("vec2({}, {})", fields[0].toValue().code, fields[1].toValue().code)};
+            return {type, std::format("vec2({}, {})", fields[0].toValue().code, fields[1].toValue().code), constant};
         }
         else if (type == Types::vec3)
         {
@@ -93,7 +96,8 @@ struct ValueField
                     std::format("vec3({}, {}, {})",
                                 fields[0].toValue().code,
                                 fields[1].toValue().code,
-                                fields[2].toValue().code)};
+                                fields[2].toValue().code),
+                    constant};
         }
         else if (type == Types::vec4)
         {
@@ -102,7 +106,8 @@ struct ValueField
                                 fields[0].toValue().code,
                                 fields[1].toValue().code,
                                 fields[2].toValue().code,
-                                fields[3].toValue().code)};
+                                fields[3].toValue().code),
+                    constant};
         }
 
         assert(false);
@@ -2,6 +2,7 @@
 
 #include "graph-utils.hpp"
 #include "graph.hpp"
+#include "profiler.hpp"
 
 #include <algorithm>
 #include <unordered_set>
@@ -41,7 +42,7 @@ public:
             {
                 nodeToLayer[node] = layer;
 
-                for (const auto link : graph->links)
+                for (const auto link : graph->getLinks(node))
                 {
                     if (link.to().nodeId() == node)
                     {
@@ -79,7 +80,7 @@ public:
                         continue;
                     }
 
-                    for (const auto link : graph->links)
+                    for (const auto link : graph->getLinks(pred))
                     {
                         if (link.to().nodeId() == pred)
                         {
@@ -134,6 +135,8 @@ public:
 
     void format()
     {
+        PROFILE_SCOPE("Formatter::format");
+
         auto nodes = GetStarterNodes();
         auto subgraphs = GraphUtils::findSubgraphs(*graph, nodes);
 
@@ -149,7 +152,7 @@ public:
             sf::FloatRect oldBound;
             if (isFirstSubGraph)
             {
-                oldBound = GraphUtils::getNodesBound(subgraph);
+                oldBound = GraphUtils::getNodesBound(*graph, subgraph);
             }
 
             float maxLayerHeight{};
@@ -172,7 +175,7 @@ public:
                 for (int nodeIndex = 0; nodeIndex < layer.size(); nodeIndex++)
                 {
                     auto node = layer[nodeIndex];
-                    ed::SetNodePosition(node, layerOrigin);
+                    graph->getNode<Graph::Node>(node).setPosition(layerOrigin);
                     layerOrigin.y += verticalSpacing;
                     layerOrigin.y += ed::GetNodeSize(node).y;
                 }
@@ -187,7 +190,7 @@ public:
 
             if (isFirstSubGraph)
             {
-                auto newBound = GraphUtils::getNodesBound(subgraph);
+                auto newBound = GraphUtils::getNodesBound(*graph, subgraph);
 
                 auto oldCenter = oldBound.position + oldBound.size / 2.f;
                 auto newCenter = newBound.position + newBound.size / 2.f;
@@ -199,7 +202,8 @@ public:
                 {
                     for (auto node : layer)
                     {
-                        ed::SetNodePosition(node, ed::GetNodePosition(node) + offset);
+                        auto& graphNode = graph->getNode<Graph::Node>(node);
+                        graphNode.setPosition(graphNode.position + offset);
                     }
                 }
             }
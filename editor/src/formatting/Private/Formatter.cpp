@@ -31,7 +31,8 @@ void FFormatter::Translate(std::unordered_set<NodeId> Nodes, sf::Vector2f Offset
     }
     for (auto Node : Nodes)
     {
-        ed::SetNodePosition(Node.Get(), ed::GetNodePosition(Node.Get()) + ImVec2{Offset.x, Offset.y});
+        auto& GraphNode = UEGraphAdapter::CurrentGraph->getNode<Graph::Node>(Node);
+        GraphNode.setPosition(GraphNode.position + ImVec2{Offset.x, Offset.y});
     }
 }
 
@@ -124,7 +125,7 @@ void FFormatter::Format()
     delete Graph;
     for (auto [Node, Rect] : BoundMap)
     {
-        ed::SetNodePosition(Node, Rect.position);
+        UEGraphAdapter::CurrentGraph->getNode<Graph::Node>(Node).setPosition(Rect.position);
     }
 }
 
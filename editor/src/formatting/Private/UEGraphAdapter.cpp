@@ -21,8 +21,8 @@ sf::Vector2f UEGraphAdapter::GetNodeSize(NodeId Node)
 
 sf::Vector2f UEGraphAdapter::GetNodePosition(NodeId Node)
 {
-	const auto size = ed::GetNodePosition(Node);
-	return { size.x, size.y };
+	const auto position = CurrentGraph->getNode<Graph::Node>(Node).position;
+	return { position.x, position.y };
 }
 
 sf::FloatRect UEGraphAdapter::GetNodesBound(const std::unordered_set<NodeId> Nodes)
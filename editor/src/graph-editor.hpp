@@ -2,6 +2,8 @@
 
 #include "graph.hpp"
 #include "misc/cpp/imgui_stdlib.h"
+#include "profiler.hpp"
+#include "undo-history.hpp"
 
 // Nodes
 #include "nodes/archetypes.hpp"
@@ -20,27 +22,90 @@ struct GraphEditor
 
     ArchetypeRepo& archetypes;
 
-    std::vector<PinId> newNodeTargetPins;
+    // The node handle catches a target whose node got deleted, and its id reused, while the popup was open
+    struct TargetPin
+    {
+        PinId pin;
+        IdPool<ShortId>::Handle node;
+    };
+    std::vector<TargetPin> newNodeTargetPins;
     bool newNodeFilterType = true;
 
-    bool canTarget(ValueType outType, ValueType inType)
+    struct ViewState
+    {
+        float zoom = 1.f;
+        ImVec2 scroll{};
+    };
+
+    // Like node positions, the view is owned here and mirrored to the editor context, so serialization never needs one
+    ViewState view;
+    bool viewDirty = false;
+
+    // Nodes outside the view, grown by this many screen pixels, and every node below this zoom are drawn as proxies
+    static constexpr float cullMargin = 64.f;
+    static constexpr float summaryZoom = 0.4f;
+
+    UndoHistory history;
+
+    // Last committed state of every node, the "before" half of the next undo step
+    struct CommittedNode
+    {
+        std::string state;
+        std::string archetype;
+        ImVec2 position;
+    };
+    std::unordered_map<NodeId, CommittedNode> committedNodes;
+    std::unordered_set<NodeId> movedNodes;
+    std::uint64_t committedRevision{};
+    bool historyBaselineDirty = true;
+
+    // Applied at the start of the next update, so nodes rebuild their pins before anything draws them
+    enum class HistoryRequest
+    {
+        None,
+        Undo,
+        Redo,
+    };
+    HistoryRequest historyRequest = HistoryRequest::None;
+
+    // Journal revision node updates and pin links are in sync with
+    std::uint64_t refreshedRevision{};
+    bool contextChanged = true;
+
+    void pushNodePosition(Graph::Node& node)
     {
-        if (canConvert(outType, inType))
+        if (node.positionDirty)
         {
-            return true;
+            ed::SetNodePosition(node.id, node.position);
+            node.positionDirty = false;
         }
+    }
 
-        if (!outType && inType.isGenType())
+    // Nodes only move in the editor while being dragged, and only selected nodes can be dragged
+    void pullSelectedNodePositions()
+    {
+        if (!ImGui::IsMouseDown(ImGuiMouseButton_Left) && !ImGui::IsMouseReleased(ImGuiMouseButton_Left))
         {
-            return true;
+            return;
         }
 
-        if (outType.isGenType() && !inType)
+        for (const auto nodeId : GraphUtils::getSelectedNodes())
         {
-            return true;
+            if (auto* node = graph.findNode<Graph::Node>(nodeId); node && !node->positionDirty)
+            {
+                const auto position = ed::GetNodePosition(nodeId);
+                if (position.x != node->position.x || position.y != node->position.y)
+                {
+                    node->position = position;
+                    movedNodes.insert(nodeId);
+                }
+            }
         }
+    }
 
-        return false;
+    static bool canTarget(ValueType outType, ValueType inType)
+    {
+        return canConnect(outType, inType);
     }
 
     bool canTarget(PinId out, PinId in)
@@ -70,6 +135,11 @@ struct GraphEditor
             std::swap(in, out);
         }
 
+        if (graph.wouldCreateCycle(out.nodeId(), in.nodeId()))
+        {
+            return false;
+        }
+
         const auto& outNode = graph.getNode<ExpressionNode>(out.nodeId());
         const auto& outArchetype = *outNode.archetype;
         const auto outIndex = out.index();
@@ -223,6 +293,36 @@ struct GraphEditor
         return -1;
     }
 
+    // Output types that could feed the pin, from its current type and every overload of its node
+    TypeMasks::Mask sourcesOfInput(PinId in)
+    {
+        const auto& inNode = graph.getNode<ExpressionNode>(in.nodeId());
+        const auto inputIndex = in.index();
+
+        auto mask = TypeMasks::sourcesOf(inNode.inputs[inputIndex].type);
+        for (const auto& inOverload : inNode.archetype->overloads)
+        {
+            mask |= TypeMasks::sourcesOf(inOverload.inputs[inputIndex]);
+        }
+
+        return mask;
+    }
+
+    // Types the pin may produce, from its current type and every overload of its node
+    TypeMasks::Mask typesOfOutput(PinId out)
+    {
+        const auto& outNode = graph.getNode<ExpressionNode>(out.nodeId());
+        const auto outIndex = out.index();
+
+        auto mask = TypeMasks::of(outNode.outputs[outIndex].type);
+        for (const auto& outOverload : outNode.archetype->overloads)
+        {
+            mask |= TypeMasks::of(outOverload.outputs[outIndex]);
+        }
+
+        return mask;
+    }
+
     void updateCreate()
     {
         if (ed::BeginCreate())
@@ -317,16 +417,16 @@ struct GraphEditor
                     {
                         if (bridge->connectionMode == BridgeNode::ConnectionMode::Input)
                         {
-                            newNodeTargetPins.push_back(pinId.nodeId().makeInput(0));
+                            addNewNodeTarget(pinId.nodeId().makeInput(0));
                         }
                         else
                         {
-                            newNodeTargetPins.push_back(pinId.nodeId().makeOutput(0));
+                            addNewNodeTarget(pinId.nodeId().makeOutput(0));
                         }
                     }
                     else
                     {
-                        newNodeTargetPins.push_back(pinId);
+                        addNewNodeTarget(pinId);
                     }
 
                     ed::Suspend();
@@ -365,12 +465,19 @@ struct GraphEditor
         ed::EndDelete(); // Wrap up deletion action
     }
 
+    void addNewNodeTarget(PinId pin)
+    {
+        newNodeTargetPins.push_back({pin, graph.idPool.makeHandle(pin.nodeId().Get())});
+    }
+
     void createNewNodePopup()
     {
         ed::Suspend();
         ImGui::SetNextWindowSize({300.f, 400.f});
         if (ImGui::BeginPopup("Create New Node"))
         {
+            std::erase_if(newNodeTargetPins, [&](const auto& target) { return !graph.idPool.isCurrent(target.node); });
+
             ImGui::Dummy({200.f, 0.f});
 
             auto newNodePostion = ed::ScreenToCanvas(ImGui::GetMousePosOnOpeningCurrentPopup());
@@ -404,7 +511,8 @@ struct GraphEditor
 
             if (openAll || ImGui::IsWindowAppearing())
             {
-                selectionIndex = -1;
+                // The best search match is preselected, Enter creates it
+                selectionIndex = filterStr.empty() ? -1 : 0;
             }
 
             bool selectionChanged = false;
@@ -424,125 +532,123 @@ struct GraphEditor
 
             const bool createAtIndex = ImGui::IsKeyPressed(ImGuiKey_Enter);
 
-            std::unordered_map<std::string, std::vector<std::string>> categories;
+            // What the new node must produce to feed a target input, or accept from a target output.
+            // Same answer as findConnectTarget, reduced to one mask test per archetype.
+            bool anyTargetIsBridge = false;
+            TypeMasks::Mask targetSources;
+            TypeMasks::Mask targetProducts;
 
-            const auto isNameFilteredOut = [&](const auto& arch)
+            for (const auto [targetPin, _] : newNodeTargetPins)
             {
-                if (filterStr.empty())
+                if (graph.findNode<BridgeNode>(targetPin.nodeId()))
                 {
-                    return false;
+                    anyTargetIsBridge = true;
                 }
-
-                if (arch.category.contains(filterStr))
+                else if (targetPin.direction() == PinDirection::In)
                 {
-                    return false;
+                    targetSources |= sourcesOfInput(targetPin);
                 }
-
-                if (arch.id.contains(filterStr))
+                else
                 {
-                    return false;
+                    targetProducts |= typesOfOutput(targetPin);
                 }
+            }
 
-                if (arch.title.contains(filterStr))
+            const auto isTypeFilteredOut = [&](const NodeArchetype& arch)
+            {
+                if (!newNodeFilterType || newNodeTargetPins.empty() || anyTargetIsBridge)
                 {
                     return false;
                 }
 
-                return true;
+                return (arch.producedTypes & targetSources).none() && (arch.acceptedTypes & targetProducts).none();
             };
 
-            const auto isTypeFilteredOut = [&](const auto& arch)
+            int currentIndex = 0;
+
+            const auto drawOption = [&](const NodeArchetype& archetype)
             {
-                if (!newNodeFilterType)
+                const auto isSelected = selectionIndex == currentIndex;
+
+                if (isSelected)
                 {
-                    return false;
+                    ImGui::PushStyleColor(ImGuiCol_MenuBarBg, ImVec4(0.26f, 0.59f, 0.98f, 0.80f));
                 }
 
-                if (newNodeTargetPins.empty())
+                ImGui::PushID(&archetype);
+                if (ImGui::Selectable(archetype.title.c_str(), isSelected) || (createAtIndex && isSelected))
                 {
-                    return false;
+                    newNode = graph.AddNode(archetype.createNode(graph.nodeArena)).id;
+                    archetypes.search.recordUse(archetype);
                 }
+                ImGui::PopID();
 
-                for (const auto targetPin : newNodeTargetPins)
+                if (isSelected && selectionChanged)
                 {
-                    if (targetPin.direction() == PinDirection::In)
-                    {
-                        if (findConnectTarget(arch, targetPin) >= 0)
-                        {
-                            return false;
-                        }
-                    }
-                    else
-                    {
-                        if (findConnectTarget(targetPin, arch) >= 0)
-                        {
-                            return false;
-                        }
-                    }
+                    ImGui::ScrollToRect(ImGui::GetCurrentWindow(), {ImGui::GetItemRectMin(), ImGui::GetItemRectMax()});
                 }
 
-                return true;
-            };
-
-            for (const auto& [id, archetype] : archetypes.archetypes)
-            {
-                if (!isNameFilteredOut(archetype) && !isTypeFilteredOut(archetype))
+                if (isSelected)
                 {
-                    categories[archetype.category].push_back(archetype.id);
+                    ImGui::PopStyleColor(1);
                 }
-            }
 
-            int currentIndex = 0;
+                currentIndex++;
+            };
 
-            for (auto& [category, archetypeIds] : categories)
+            if (!filterStr.empty())
             {
-                if (category.empty())
+                // Searching shows one flat list, best match first
+                ImGui::BeginChild("options");
+                for (const auto& result : archetypes.search.find(filterStr))
                 {
-                    continue;
-                }
-
-                std::ranges::sort(archetypeIds);
+                    if (!isTypeFilteredOut(*result.archetype))
+                    {
+                        drawOption(*result.archetype);
 
-                if (openAll)
+                        ImGui::SameLine();
+                        ImGui::TextDisabled("%s", result.archetype->category.c_str());
+                    }
+                }
+                ImGui::EndChild();
+            }
+            else
+            {
+                std::unordered_map<std::string, std::vector<const NodeArchetype*>> categories;
+                for (const auto& [id, archetype] : archetypes.archetypes)
                 {
-                    ImGui::SetNextItemOpen(true);
+                    if (!isTypeFilteredOut(archetype))
+                    {
+                        categories[archetype.category].push_back(&archetype);
+                    }
                 }
 
-                ImGui::BeginChild("options");
-                if (ImGui::TreeNodeEx(category.c_str(), ImGuiTreeNodeFlags_SpanFullWidth, category.c_str()))
+                for (auto& [category, categoryArchetypes] : categories)
                 {
-                    for (const auto& archetypeId : archetypeIds)
+                    if (category.empty())
                     {
-                        const auto& archetype = archetypes.archetypes[archetypeId];
-                        const auto isSelected = selectionIndex == currentIndex;
+                        continue;
+                    }
 
-                        if (isSelected)
-                        {
-                            ImGui::PushStyleColor(ImGuiCol_MenuBarBg, ImVec4(0.26f, 0.59f, 0.98f, 0.80f));
-                        }
+                    std::ranges::sort(categoryArchetypes, {}, &NodeArchetype::id);
 
-                        if (ImGui::Selectable(archetype.title.c_str(), isSelected) || (createAtIndex && isSelected))
-                        {
-                            newNode = graph.AddNode(archetype.createNode()).id;
-                        }
-
-                        if (isSelected && selectionChanged)
-                        {
-                            ImGui::ScrollToRect(ImGui::GetCurrentWindow(),
-                                                {ImGui::GetItemRectMin(), ImGui::GetItemRectMax()});
-                        }
+                    if (openAll)
+                    {
+                        ImGui::SetNextItemOpen(true);
+                    }
 
-                        if (isSelected)
+                    ImGui::BeginChild("options");
+                    if (ImGui::TreeNodeEx(category.c_str(), ImGuiTreeNodeFlags_SpanFullWidth, category.c_str()))
+                    {
+                        for (const auto* archetype : categoryArchetypes)
                         {
-                            ImGui::PopStyleColor(1);
+                            drawOption(*archetype);
                         }
 
-                        currentIndex++;
+                        ImGui::TreePop();
                     }
-
-                    ImGui::TreePop();
+                    ImGui::EndChild();
                 }
-                ImGui::EndChild();
             }
 
             ImGui::PopStyleVar();
@@ -556,11 +662,12 @@ struct GraphEditor
             {
                 ImGui::CloseCurrentPopup();
 
-                ed::SetNodePosition(newNode, newNodePostion);
+                auto& newExpressionNode = graph.getNode<ExpressionNode>(newNode);
+                newExpressionNode.setPosition(newNodePostion);
 
-                const auto& arch = *graph.findNode<ExpressionNode>(newNode)->archetype;
+                const auto& arch = *newExpressionNode.archetype;
 
-                for (const auto targetPin : newNodeTargetPins)
+                for (const auto [targetPin, _] : newNodeTargetPins)
                 {
                     if (targetPin.direction() == PinDirection::In)
                     {
@@ -598,15 +705,24 @@ struct GraphEditor
             graph.links.clear();
         }
 
-        NodeSerializer::repo = &archetypes;
-        s.serialize("nodes", graph.nodes);
+        auto nodesSerializer = s.at("nodes");
+        NodeSerializer{archetypes, graph.nodeArena}.serialize(nodesSerializer, graph.nodes);
         s.serialize("links", graph.links);
 
-        s.serializeValue<float>("zoom", &ed::GetViewZoom, &ed::SetViewZoom);
-        s.serializeValue<ImVec2>("scroll", &ed::GetViewScroll, &ed::SetViewScroll);
+        s.serialize("zoom", view.zoom);
+        s.serialize("scroll", view.scroll);
 
-        if (!s.isSaving)
+        if (s.isSaving)
+        {
+            // Saved ids are renumbered densely, so reloading starts from a compact id range
+            ShortId nextId{};
+            remapNodeIds(s.j, [&](NodeId) { return NodeId{++nextId}; });
+        }
+        else
         {
+            graph.invalidateJournal();
+            viewDirty = true;
+
             ShortId maxId{};
             for (const auto& node : graph.nodes)
             {
@@ -617,8 +733,326 @@ struct GraphEditor
 
                 maxId = std::max(maxId, node->id.Get());
             }
-            graph.idPool.reset(maxId + 1);
+            graph.idPool.reset(maxId);
+
+            graph.rebuildNodeIndex();
+            graph.rebuildLinkIndex();
+
+            resetHistory();
+        }
+    }
+
+    // Takes over another editor's view and starts a fresh history, the graph itself is copied by Graph::copyFrom
+    void copyStateFrom(const GraphEditor& other)
+    {
+        view = other.view;
+        viewDirty = true;
+        newNodeTargetPins.clear();
+
+        resetHistory();
+    }
+
+    static std::string serializeNode(Graph::Node& node)
+    {
+        json j;
+        Serializer s(true, j);
+        NodeSerializer::save(s, &node);
+        return j.dump();
+    }
+
+    static const std::string& archetypeOf(const Graph::Node& node)
+    {
+        return static_cast<const ExpressionNode&>(node).archetype->id;
+    }
+
+    void resetHistory()
+    {
+        history.clear();
+        movedNodes.clear();
+        committedNodes.clear();
+        graph.retainJournal();
+
+        // Built by the next update, so tabs that are loaded or copied but never shown don't pay for it
+        historyBaselineDirty = true;
+    }
+
+    void buildHistoryBaseline()
+    {
+        for (const auto& node : graph.nodes)
+        {
+            if (node)
+            {
+                committedNodes.emplace(node->id, CommittedNode{serializeNode(*node), archetypeOf(*node), node->position});
+            }
+        }
+
+        committedRevision = graph.revision();
+        graph.retainJournal(committedRevision);
+        historyBaselineDirty = false;
+    }
+
+    // Diffs the graph against the committed state using the journal, and makes the current state the committed one
+    UndoHistory::Step collectHistoryStep()
+    {
+        // The journal is retained from committedRevision, so only invalidateJournal() leaves a gap
+        const auto changes = graph.changesSince(committedRevision);
+        if (!changes)
+        {
+            resetHistory();
+            buildHistoryBaseline();
+            return {};
+        }
+
+        committedRevision = graph.revision();
+        graph.retainJournal(committedRevision);
+
+        std::unordered_set<NodeId> touchedNodes;
+        // The first change of a link tells whether it existed before
+        std::unordered_map<LinkId, bool> linksExistedBefore;
+
+        for (const auto& change : *changes)
+        {
+            switch (change.type)
+            {
+                case GraphChange::Type::LinkAdded:
+                    linksExistedBefore.try_emplace(change.link, false);
+                    break;
+                case GraphChange::Type::LinkRemoved:
+                    linksExistedBefore.try_emplace(change.link, true);
+                    break;
+                default:
+                    touchedNodes.insert(change.node);
+                    break;
+            }
+        }
+
+        UndoHistory::Step step;
+
+        for (const auto [link, existedBefore] : linksExistedBefore)
+        {
+            if (const bool exists = graph.hasLink(link); exists != existedBefore)
+            {
+                (exists ? step.linksAdded : step.linksRemoved).push_back(link);
+            }
+        }
+
+        for (const auto nodeId : touchedNodes)
+        {
+            UndoHistory::NodeDelta delta{nodeId};
+
+            if (auto it = committedNodes.find(nodeId); it != committedNodes.end())
+            {
+                delta.before = std::move(it->second.state);
+                delta.beforeArchetype = std::move(it->second.archetype);
+                committedNodes.erase(it);
+            }
+
+            if (auto* node = graph.findNode<Graph::Node>(nodeId))
+            {
+                delta.after = serializeNode(*node);
+                delta.afterArchetype = archetypeOf(*node);
+                committedNodes.emplace(nodeId, CommittedNode{delta.after, delta.afterArchetype, node->position});
+                movedNodes.erase(nodeId);
+            }
+
+            if (delta.before != delta.after)
+            {
+                step.nodes.push_back(std::move(delta));
+            }
         }
+
+        for (const auto nodeId : movedNodes)
+        {
+            auto* node = graph.findNode<Graph::Node>(nodeId);
+            const auto it = committedNodes.find(nodeId);
+            if (!node || it == committedNodes.end())
+            {
+                continue;
+            }
+
+            auto& committed = it->second;
+            if (committed.position.x == node->position.x && committed.position.y == node->position.y)
+            {
+                continue;
+            }
+
+            step.moves.push_back({nodeId, committed.position, node->position});
+
+            committed.position = node->position;
+
+            auto j = json::parse(committed.state);
+            Serializer(true, j).serialize("pos", committed.position);
+            committed.state = j.dump();
+        }
+        movedNodes.clear();
+
+        return step;
+    }
+
+    // Waits for the mouse and active widgets to be released, so a whole drag or text edit becomes one step
+    void commitHistory()
+    {
+        if (ImGui::IsAnyItemActive() || ImGui::IsMouseDown(ImGuiMouseButton_Left))
+        {
+            return;
+        }
+
+        if (auto step = collectHistoryStep(); !step.empty())
+        {
+            history.push(std::move(step));
+        }
+    }
+
+    // Links go away before the nodes they point to and come back after them. False when a removed node can't get
+    // its id back because another node holds it, the history no longer matches the graph and the step stops there.
+    bool applyHistoryStep(const UndoHistory::Step& step, bool forward)
+    {
+        for (const auto link : forward ? step.linksRemoved : step.linksAdded)
+        {
+            graph.removeLink(link);
+        }
+
+        for (const auto& delta : step.nodes)
+        {
+            const auto& state = forward ? delta.after : delta.before;
+            if (state.empty())
+            {
+                graph.removeNode(delta.node);
+                continue;
+            }
+
+            auto j = json::parse(state);
+            Serializer s(false, j);
+
+            // The id may have been freed and reused by a node of another type within the step, that node is
+            // replaced rather than loaded with a state it can't read
+            auto* node = graph.findNode<ExpressionNode>(delta.node);
+            if (node && node->archetype->id != (forward ? delta.afterArchetype : delta.beforeArchetype))
+            {
+                graph.removeNode(delta.node);
+                node = nullptr;
+            }
+
+            if (node)
+            {
+                node->serialize(s);
+                graph.recordChange(GraphChange::Type::NodeEdited, node->id);
+            }
+            else
+            {
+                Graph::Node::Ptr restored;
+                NodeSerializer{archetypes, graph.nodeArena}.serialize(s, restored);
+                if (!graph.idPool.claim(restored->id.Get()))
+                {
+                    return false;
+                }
+
+                graph.AddNode(std::move(restored));
+            }
+        }
+
+        for (const auto& move : step.moves)
+        {
+            if (auto* node = graph.findNode<Graph::Node>(move.node))
+            {
+                node->setPosition(forward ? move.after : move.before);
+                movedNodes.insert(move.node);
+            }
+        }
+
+        for (const auto link : forward ? step.linksAdded : step.linksRemoved)
+        {
+            graph.addLink(link.from(), link.to());
+        }
+
+        return true;
+    }
+
+    void undo()
+    {
+        historyRequest = HistoryRequest::Undo;
+    }
+
+    void redo()
+    {
+        historyRequest = HistoryRequest::Redo;
+    }
+
+    bool applyHistoryRequest()
+    {
+        const auto request = std::exchange(historyRequest, HistoryRequest::None);
+        if (request == HistoryRequest::None)
+        {
+            return false;
+        }
+
+        // Whatever is still uncommitted becomes its own step first
+        if (auto step = collectHistoryStep(); !step.empty())
+        {
+            history.push(std::move(step));
+        }
+
+        const bool forward = request == HistoryRequest::Redo;
+        const auto* step = forward ? history.redo() : history.undo();
+        if (!step)
+        {
+            return false;
+        }
+
+        if (!applyHistoryStep(*step, forward))
+        {
+            // Whatever was applied stays, as the new starting point
+            resetHistory();
+            buildHistoryBaseline();
+        }
+
+        return true;
+    }
+
+    // The link between the same pins of the renumbered nodes, none when either node isn't in the map
+    static std::optional<LinkId> remapLink(LinkId link, const std::unordered_map<NodeId, NodeId>& newIds)
+    {
+        const auto from = newIds.find(link.from().nodeId());
+        const auto to = newIds.find(link.to().nodeId());
+        if (from == newIds.end() || to == newIds.end())
+        {
+            return std::nullopt;
+        }
+
+        return LinkId{PinId::makeOutput(from->second, link.from().index()),
+                      PinId::makeInput(to->second, link.to().index())};
+    }
+
+    // Rewrites node ids, and the pins of links, inside a serialized graph. Links to a node that isn't in it
+    // are dropped rather than failing the whole save.
+    template <typename F>
+    static void remapNodeIds(json& j, F&& getNewId)
+    {
+        std::unordered_map<NodeId, NodeId> newIdMap;
+        for (auto& node : j["nodes"])
+        {
+            const NodeId oldId = node["id"].template get<NodeId::InnerType>();
+            const NodeId newId = getNewId(oldId);
+            newIdMap.emplace(oldId, newId);
+            node["id"] = newId.Get();
+        }
+
+        auto& links = j["links"];
+        if (!links.is_array())
+        {
+            return;
+        }
+
+        json newLinks = json::array();
+        for (const auto& link : links)
+        {
+            if (const auto newLink = remapLink(LinkId{link.template get<LinkId::InnerType>()}, newIdMap))
+            {
+                newLinks.push_back(newLink->Get());
+            }
+        }
+
+        links = std::move(newLinks);
     }
 
     std::string copySelectedToString()
@@ -643,8 +1077,6 @@ struct GraphEditor
         json j;
         Serializer s(true, j);
 
-        NodeSerializer::repo = &archetypes;
-
         s.serialize("nodes", nodesToSave);
         s.serialize("links", links);
 
@@ -663,30 +1095,39 @@ struct GraphEditor
                 return;
             }
 
-            std::unordered_map<NodeId, NodeId> newIdMap;
-            for (auto& node : j["nodes"])
-            {
-                const auto oldId = node["id"].template get<NodeId::InnerType>();
-                const auto newId = graph.idPool.take();
-                newIdMap.emplace(oldId, newId);
-                node["id"] = newId;
-            }
-
             Serializer s(false, j);
-            NodeSerializer::repo = &archetypes;
 
             std::vector<LinkId> links;
             std::vector<Graph::Node::Ptr> nodes;
 
-            s.serialize("nodes", nodes);
+            auto nodesSerializer = s.at("nodes");
+            NodeSerializer{archetypes, graph.nodeArena}.serialize(nodesSerializer, nodes);
             s.serialize("links", links);
 
+            // Ids are only taken once everything parsed, so a bad clipboard doesn't leak any
+            std::unordered_map<NodeId, NodeId> newIds;
+            for (auto& node : nodes)
+            {
+                const NodeId newId{graph.idPool.take()};
+                newIds.emplace(node->id, newId);
+                node->id = newId;
+            }
+
+            std::vector<LinkId> newLinks;
+            for (const auto link : links)
+            {
+                if (const auto newLink = remapLink(link, newIds))
+                {
+                    newLinks.push_back(*newLink);
+                }
+            }
+
             sf::Vector2f boundsMin;
             sf::Vector2f boundsMax;
 
             for (const auto& node : nodes)
             {
-                const auto pos = ed::GetNodePosition(node->id);
+                const auto pos = node->position;
 
                 boundsMin.x = std::min(boundsMin.x, pos.x);
                 boundsMin.y = std::min(boundsMin.y, pos.y);
@@ -703,21 +1144,16 @@ struct GraphEditor
             ed::ClearSelection();
             for (auto& node : nodes)
             {
-                const auto id = node->id;
-                ed::SelectNode(id, true);
-                ed::SetNodePosition(id, ed::GetNodePosition(id) + offset);
+                // Pushed right away so the editor knows the node and can select it
+                node->setPosition(node->position + offset);
+                pushNodePosition(*node);
+                ed::SelectNode(node->id, true);
                 graph.AddNode(std::move(node));
             }
 
-            for (auto& link : links)
+            for (const auto link : newLinks)
             {
-                PinId from = link.from();
-                PinId to = link.to();
-
-                to = PinId::makeInput(newIdMap.at(to.nodeId()), to.index());
-                from = PinId::makeOutput(newIdMap.at(from.nodeId()), from.index());
-
-                graph.addLink(from, to);
+                graph.addLink(link.from(), link.to());
             }
         } catch (...)
         {
@@ -744,7 +1180,7 @@ struct GraphEditor
                 continue;
             }
 
-            if (auto* n = dynamic_cast<OutputNode*>(node.get()))
+            if (auto* n = Graph::cast<OutputNode>(node.get()))
             {
                 if (n->type == CodeGenerator::Type::Vertex)
                 {
@@ -759,28 +1195,87 @@ struct GraphEditor
 
         if (!vertexOutFound)
         {
-            auto node = graph.AddNode(archetypes.get("out_vertex").createNode());
-            ed::SetNodePosition(node.id,
-                                ed::GetViewScroll() / ed::GetViewZoom() + ed::GetViewSize() * ImVec2(1.f, 0.5f) +
-                                    ImVec2(-200.f, -100.f));
+            auto& node = graph.AddNode(archetypes.get("out_vertex").createNode(graph.nodeArena));
+            node.setPosition(ed::GetViewScroll() / ed::GetViewZoom() + ed::GetViewSize() * ImVec2(1.f, 0.5f) +
+                             ImVec2(-200.f, -100.f));
         }
 
         if (!fragmentOutFound)
         {
-            auto node = graph.AddNode(archetypes.get("out_fragment").createNode());
-            ed::SetNodePosition(node.id,
-                                ed::GetViewScroll() / ed::GetViewZoom() + ed::GetViewSize() * ImVec2(1.f, 0.5f) +
-                                    ImVec2(-200.f, 100.f));
+            auto& node = graph.AddNode(archetypes.get("out_fragment").createNode(graph.nodeArena));
+            node.setPosition(ed::GetViewScroll() / ed::GetViewZoom() + ed::GetViewSize() * ImVec2(1.f, 0.5f) +
+                             ImVec2(-200.f, 100.f));
         }
     }
 
-    void draw()
+    // ImGui flags at most one edited widget per frame, so the node whose draw raised the flag is the one that changed
+    void drawNode(ExpressionNode& node)
     {
-        const auto mousePos = ImGui::GetMousePos();
+        const auto& imguiContext = *ImGui::GetCurrentContext();
+        const bool editedBefore = imguiContext.ActiveIdHasBeenEditedThisFrame;
 
-        ImGui::BeginChild("graph", {}, false, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
-        ImGui::Separator();
-        ed::Begin("graph-editor", ImVec2(0.0, 0.0f));
+        node.draw();
+
+        if ((!editedBefore && imguiContext.ActiveIdHasBeenEditedThisFrame) || node.edited)
+        {
+            node.edited = false;
+
+            const auto type = node.kind == NodeKind::Parameter ? GraphChange::Type::ParameterBindingChanged
+                                                               : GraphChange::Type::NodeEdited;
+            graph.recordChange(type, node.id);
+        }
+    }
+
+    // Keeps the footprint of a fully drawn node so a proxy can stand in for it while it isn't worth drawing
+    void recordLayout(ExpressionNode& node)
+    {
+        auto& editor = *reinterpret_cast<ax::NodeEditor::Detail::EditorContext*>(ed::GetCurrentEditor());
+
+        auto* editorNode = editor.FindNode(node.id);
+        if (!editorNode || !editorNode->m_IsLive)
+        {
+            return;
+        }
+
+        const auto origin = editorNode->m_Bounds.Min;
+        node.drawnSize = editorNode->m_Bounds.GetSize();
+        node.drawnPins.clear();
+
+        const auto recordPin = [&](PinId pinId)
+        {
+            const auto* pin = editor.FindPin(pinId);
+            if (pin && pin->m_IsLive && pin->m_Node == editorNode)
+            {
+                node.drawnPins.push_back({pinId,
+                                          pin->m_Bounds.Min - origin,
+                                          pin->m_Bounds.Max - origin,
+                                          pin->m_Pivot.Min - origin,
+                                          pin->m_Pivot.Max - origin,
+                                          pin->m_Dir});
+            }
+        };
+
+        for (PinId::PinIndex x{}; x < node.inputs.size(); x++)
+        {
+            recordPin(node.id.makeInput(x));
+        }
+
+        for (PinId::PinIndex x{}; x < node.outputs.size(); x++)
+        {
+            recordPin(node.id.makeOutput(x));
+        }
+    }
+
+    // Only nodes in view get their widgets, the rest keep their footprint through a proxy
+    void drawNodes()
+    {
+        auto& editor = *reinterpret_cast<ax::NodeEditor::Detail::EditorContext*>(ed::GetCurrentEditor());
+
+        const auto zoom = ed::GetViewZoom();
+        const bool summarize = zoom < summaryZoom;
+
+        auto viewRect = editor.GetViewRect();
+        viewRect.Expand(cullMargin / zoom);
 
         for (auto& node : graph.nodes)
         {
@@ -789,13 +1284,51 @@ struct GraphEditor
                 continue;
             }
 
-            static_cast<ExpressionNode&>(*node).draw();
+            pushNodePosition(*node);
+
+            auto& expressionNode = static_cast<ExpressionNode&>(*node);
+
+            if (expressionNode.hasDrawnLayout())
+            {
+                const auto position = ed::GetNodePosition(node->id);
+                const bool inView = viewRect.Overlaps({position, position + expressionNode.drawnSize});
+
+                if (!inView || summarize)
+                {
+                    expressionNode.drawProxy(inView);
+                    continue;
+                }
+            }
+
+            drawNode(expressionNode);
+            recordLayout(expressionNode);
         }
+    }
+
+    void draw()
+    {
+        PROFILE_SCOPE("GraphEditor::draw");
+
+        const auto mousePos = ImGui::GetMousePos();
+
+        ImGui::BeginChild("graph", {}, false, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
+        ImGui::Separator();
+
+        if (viewDirty)
+        {
+            ed::SetViewZoom(view.zoom);
+            ed::SetViewScroll(view.scroll);
+            viewDirty = false;
+        }
+
+        ed::Begin("graph-editor", ImVec2(0.0, 0.0f));
+
+        drawNodes();
 
         if (const LinkId link = ed::GetDoubleClickedLink())
         {
-            auto& node = static_cast<ExpressionNode&>(graph.AddNode(archetypes.archetypes["bridge"].createNode()));
-            ed::SetNodePosition(node.id, ed::ScreenToCanvas(mousePos));
+            auto& node = static_cast<ExpressionNode&>(graph.AddNode(archetypes.archetypes["bridge"].createNode(graph.nodeArena)));
+            node.setPosition(ed::ScreenToCanvas(mousePos));
 
             graph.addLink(link.from(), node.id.makeInput(0));
             graph.addLink(node.id.makeOutput(0), link.to());
@@ -873,16 +1406,20 @@ struct GraphEditor
 
         ed::End();
 
+        pullSelectedNodePositions();
+        view = {ed::GetViewZoom(), ed::GetViewScroll()};
+
         if (ImGui::BeginDragDropTarget())
         {
             if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("ParameterDrag"))
             {
                 std::string parameterId((const char*)payload->Data, payload->DataSize);
 
-                auto& node = static_cast<ParameterNode&>(graph.AddNode(archetypes.archetypes["parameter"].createNode()));
-                ed::SetNodePosition(node.id, ed::ScreenToCanvas(mousePos));
+                auto& node = static_cast<ParameterNode&>(graph.AddNode(archetypes.archetypes["parameter"].createNode(graph.nodeArena)));
+                node.setPosition(ed::ScreenToCanvas(mousePos));
 
                 node.parameterId = parameterId;
+                graph.recordChange(GraphChange::Type::ParameterBindingChanged, node.id);
             }
         }
 
@@ -892,66 +1429,174 @@ struct GraphEditor
         ensureOutputNodesExist();
     }
 
-    void update()
+    // Pin removal is applied here, links of the following pins shift down by one
+    void updateNode(ExpressionNode& expressionNode)
     {
-        for (auto& node : graph.nodes)
+        expressionNode.resetEvaluation();
+        expressionNode.update(&graphContext);
+        expressionNode.invalidateLayout();
+
+        auto& inputs = expressionNode.inputs;
+        for (int x{}; x < inputs.size(); x++)
         {
-            if (!node)
+            if (inputs[x].toRemove)
             {
-                continue;
-            }
+                graph.removeLinks(expressionNode.id.makeInput(x));
 
-            auto& expressionNode = static_cast<ExpressionNode&>(*node);
+                for (int y = x + 1; y < inputs.size(); y++)
+                {
+                    while (auto link = graph.findLink(expressionNode.id.makeInput(y)))
+                    {
+                        graph.removeLink(link);
+                        graph.addLink(link.from(), expressionNode.id.makeInput(y - 1));
+                    }
+                }
 
-            expressionNode.update(&graphContext);
+                inputs.erase(inputs.begin() + x);
+                x--;
+            }
+        }
 
-            auto& inputs = expressionNode.inputs;
-            for (int x{}; x < inputs.size(); x++)
+        auto& outputs = expressionNode.outputs;
+        for (int x{}; x < outputs.size(); x++)
+        {
+            if (outputs[x].toRemove)
             {
-                if (inputs[x].toRemove)
-                {
-                    graph.removeLinks(expressionNode.id.makeInput(x));
+                graph.removeLinks(expressionNode.id.makeOutput(x));
 
-                    for (int y = x + 1; y < inputs.size(); y++)
+                for (int y = x + 1; y < outputs.size(); y++)
+                {
+                    while (auto link = graph.findLink(expressionNode.id.makeOutput(y)))
                     {
-                        while (auto link = graph.findLink(expressionNode.id.makeInput(y)))
-                        {
-                            graph.removeLink(link);
-                            graph.addLink(link.from(), expressionNode.id.makeInput(y - 1));
-                        }
+                        graph.removeLink(link);
+                        graph.addLink(link.from(), expressionNode.id.makeOutput(y - 1));
                     }
-
-                    inputs.erase(inputs.begin() + x);
-                    x--;
                 }
+
+                outputs.erase(outputs.begin() + x);
+                x--;
             }
+        }
+    }
 
-            auto& outputs = expressionNode.outputs;
-            for (int x{}; x < outputs.size(); x++)
+    // Pins mirror the graph's links, recomputed from the node's own links only
+    void refreshPinLinks(ExpressionNode& node)
+    {
+        for (auto& input : node.inputs)
+        {
+            input.link = {};
+        }
+
+        for (auto& output : node.outputs)
+        {
+            output.linkCount = 0;
+        }
+
+        for (const auto link : graph.getLinks(node.id))
+        {
+            if (const auto to = link.to(); to.nodeId() == node.id && to.index() < node.inputs.size())
             {
-                if (outputs[x].toRemove)
-                {
-                    graph.removeLinks(expressionNode.id.makeOutput(x));
+                node.inputs[to.index()].link = link;
+            }
+            else if (const auto from = link.from(); from.nodeId() == node.id && from.index() < node.outputs.size())
+            {
+                node.outputs[from.index()].linkCount++;
+            }
+        }
+    }
+
+    // Graph context values, e.g. parameter types, changed, every node has to look at them again
+    void markContextChanged()
+    {
+        contextChanged = true;
+    }
+
+    // Only nodes the journal mentions since the last refresh are updated, links touch both their ends.
+    // Updating a node can remove pins and move links, so this repeats until the graph settles.
+    void refreshChangedNodes()
+    {
+        bool refreshAll = std::exchange(contextChanged, false);
+        std::unordered_set<NodeId> dirtyNodes;
+
+        while (true)
+        {
+            const auto changes = graph.changesSince(refreshedRevision);
+            refreshedRevision = graph.revision();
+
+            if (!changes || refreshAll)
+            {
+                refreshAll = false;
 
-                    for (int y = x + 1; y < outputs.size(); y++)
+                for (const auto& node : graph.nodes)
+                {
+                    if (node)
                     {
-                        while (auto link = graph.findLink(expressionNode.id.makeOutput(y)))
-                        {
-                            graph.removeLink(link);
-                            graph.addLink(link.from(), expressionNode.id.makeOutput(y - 1));
-                        }
+                        dirtyNodes.insert(node->id);
+                    }
+                }
+            }
+            else
+            {
+                for (const auto& change : *changes)
+                {
+                    if (change.link)
+                    {
+                        dirtyNodes.insert(change.link.from().nodeId());
+                        dirtyNodes.insert(change.link.to().nodeId());
+                    }
+                    else
+                    {
+                        dirtyNodes.insert(change.node);
                     }
+                }
+            }
 
-                    outputs.erase(outputs.begin() + x);
-                    x--;
+            if (dirtyNodes.empty())
+            {
+                break;
+            }
+
+            for (const auto nodeId : dirtyNodes)
+            {
+                if (auto* node = graph.findNode<ExpressionNode>(nodeId))
+                {
+                    updateNode(*node);
                 }
             }
+
+            for (const auto nodeId : dirtyNodes)
+            {
+                if (auto* node = graph.findNode<ExpressionNode>(nodeId))
+                {
+                    refreshPinLinks(*node);
+                }
+            }
+
+            dirtyNodes.clear();
         }
+    }
 
-        for (auto& link : graph.links)
+    void update()
+    {
+        PROFILE_SCOPE("GraphEditor::update");
+
+        if (historyBaselineDirty)
+        {
+            buildHistoryBaseline();
+        }
+
+        const bool appliedHistory = applyHistoryRequest();
+
+        refreshChangedNodes();
+
+        if (appliedHistory)
+        {
+            // The restored state, and the pins nodes rebuilt from it, is the new baseline
+            collectHistoryStep();
+        }
+        else
         {
-            graph.getNode<ExpressionNode>(link.to().nodeId()).inputs[link.to().index()].link = link;
-            graph.getNode<ExpressionNode>(link.from().nodeId()).outputs[link.from().index()].linkCount++;
+            commitHistory();
         }
     }
 };
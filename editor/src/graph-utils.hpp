@@ -48,25 +48,26 @@ std::unordered_set<NodeId> getSelectedNodes()
     return SelectedGraphNodes;
 }
 
-sf::FloatRect getNodeBounds(NodeId node)
+// The position is the node's own, the size is only known to the node editor once the node is drawn
+sf::FloatRect getNodeBounds(const Graph::Node& node)
 {
-    sf::Vector2f Pos = UEGraphAdapter::GetNodePosition(node);
-    sf::Vector2f Size = UEGraphAdapter::GetNodeSize(node);
+    sf::Vector2f Pos{node.position.x, node.position.y};
+    sf::Vector2f Size = UEGraphAdapter::GetNodeSize(node.id);
     return {Pos, Size};
 }
 
 sf::FloatRect getNodeBounds(const Graph::Node::Ptr& node)
 {
-    return getNodeBounds(node->id);
+    return getNodeBounds(*node);
 }
 
 template <typename T>
-sf::FloatRect getNodesBound(const T& nodes)
+sf::FloatRect getNodesBound(Graph& graph, const T& nodes)
 {
     std::optional<sf::FloatRect> Bound;
-    for (const auto& node : nodes)
+    for (const auto node : nodes)
     {
-        Bound = mergeRects(Bound, getNodeBounds(node));
+        Bound = mergeRects(Bound, getNodeBounds(graph.getNode<Graph::Node>(node)));
     }
     return Bound ? *Bound : sf::FloatRect{};
 }
@@ -81,7 +82,7 @@ std::unordered_set<NodeId> getLinkedNodes(const Graph& graph, const std::unorder
         pendingNodes.erase(Node);
         visitedNodes.emplace(Node);
 
-        for (const auto link : graph.links)
+        for (const auto link : graph.getLinks(Node))
         {
             PinId pin{0};
             PinId linkedPin{0};
@@ -118,7 +119,7 @@ std::unordered_set<NodeId> getPredecessor(const Graph& graph, const std::unorder
         pendingNodes.erase(Node);
         visitedNodes.emplace(Node);
 
-        for (const auto link : graph.links)
+        for (const auto link : graph.getLinks(Node))
         {
             if (link.to().nodeId() == Node)
             {
@@ -139,7 +140,7 @@ std::unordered_set<NodeId> getRootNodes(const Graph& graph, const std::unordered
     for (const auto& node : nodes)
     {
         bool hasOutLink = false;
-        for (const auto link : graph.links)
+        for (const auto link : graph.getLinks(node))
         {
             if (link.from().nodeId() == node)
             {
@@ -3,11 +3,31 @@
 #include "id-pool.hpp"
 #include "mls/serializer.hpp"
 
+#ifndef MLSE_HEADLESS_GRAPH
 #include <imgui_node_editor.h>
 #include <imgui_node_editor_internal.h>
-#include <set>
+#endif
 
+#include <algorithm>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <set>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef MLSE_HEADLESS_GRAPH
+// Builds without ImGui, like MLSE_tests, only need node positions to hold two floats
+struct ImVec2
+{
+    float x{};
+    float y{};
+};
+#else
 namespace ed = ax::NodeEditor;
+#endif
 
 template <typename T, typename Tag>
 struct SafeId
@@ -75,6 +95,7 @@ struct PinId : SafeId<ShortId, PinId>
 {
     using SafeId::SafeId;
 
+#ifndef MLSE_HEADLESS_GRAPH
     PinId(ed::PinId id) : PinId(static_cast<ShortId>(id.Get()))
     {
     }
@@ -83,6 +104,7 @@ struct PinId : SafeId<ShortId, PinId>
     {
         return Get();
     }
+#endif
 
     operator bool() const
     {
@@ -109,6 +131,7 @@ struct NodeId : SafeId<ShortId, NodeId>
 {
     using SafeId::SafeId;
 
+#ifndef MLSE_HEADLESS_GRAPH
     NodeId(ed::NodeId id) : SafeId(static_cast<ShortId>(id.Get()))
     {
     }
@@ -117,6 +140,7 @@ struct NodeId : SafeId<ShortId, NodeId>
     {
         return Get();
     }
+#endif
 
     operator bool() const
     {
@@ -163,6 +187,7 @@ struct LinkId : SafeId<LongId, LinkId>
 {
     using SafeId::SafeId;
 
+#ifndef MLSE_HEADLESS_GRAPH
     LinkId(ed::LinkId id) : LinkId(id.Get())
     {
     }
@@ -171,6 +196,7 @@ struct LinkId : SafeId<LongId, LinkId>
     {
         return Get();
     }
+#endif
 
     operator bool() const
     {
@@ -243,41 +269,145 @@ inline std::ostream& operator<<(std::ostream& stream, PinId id)
                   << (id.direction() == PinDirection::In ? '<' : '>') << ')';
 }
 
+// Concrete node types that get looked up by type, a type opts in by declaring a matching static nodeKind
+enum class NodeKind : std::uint8_t
+{
+    Generic,
+    Output,
+    Bridge,
+    Parameter,
+};
+
+struct GraphChange
+{
+    enum class Type : std::uint8_t
+    {
+        NodeAdded,
+        NodeRemoved,
+        LinkAdded,
+        LinkRemoved,
+        NodeEdited,
+        ParameterBindingChanged,
+    };
+
+    std::uint64_t revision;
+    Type type;
+    NodeId node{0};
+    LinkId link;
+};
+
 struct Graph
 {
+    // Gives a node's memory back to the resource it came from, see makeNode
+    struct NodeDeleter
+    {
+        std::pmr::memory_resource* resource{};
+        void* block{};
+        std::size_t size{};
+        std::size_t alignment{};
+
+        template <typename T>
+        void operator()(T* node) const
+        {
+            node->~T();
+            resource->deallocate(block, size, alignment);
+        }
+    };
+
     struct Node
     {
         NodeId id{0};
+        NodeKind kind = NodeKind::Generic;
+
+        // Canonical position in canvas space, the node editor only gets a copy when it is dirty
+        ImVec2 position{};
+        bool positionDirty = true;
+
+        void setPosition(ImVec2 newPosition)
+        {
+            position = newPosition;
+            positionDirty = true;
+        }
 
-        using Ptr = std::unique_ptr<Node>;
+        using Ptr = std::unique_ptr<Node, NodeDeleter>;
 
         virtual ~Node() = default;
+
+        // Deep copy with the same id, allocated from the given resource
+        virtual Ptr clone(std::pmr::memory_resource& resource) const = 0;
     };
 
     IdPool<ShortId> idPool;
 
+    // Node storage, declared before nodes so it outlives them
+    std::pmr::unsynchronized_pool_resource nodeArena;
+
     std::vector<Node::Ptr> nodes;
     std::set<LinkId> links;
 
+    template <typename T, typename... Args>
+    static Node::Ptr makeNode(std::pmr::memory_resource& resource, Args&&... args)
+    {
+        static_assert(std::is_base_of_v<Node, T> && std::has_virtual_destructor_v<T>);
+
+        void* block = resource.allocate(sizeof(T), alignof(T));
+
+        T* node;
+        try
+        {
+            node = new (block) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            resource.deallocate(block, sizeof(T), alignof(T));
+            throw;
+        }
+
+        return Node::Ptr{node, NodeDeleter{&resource, block, sizeof(T), alignof(T)}};
+    }
+
     Node& AddNode(Node::Ptr&& n)
     {
         if (!n->id)
         {
             n->id = idPool.take();
         }
-        return *nodes.emplace_back(std::move(n));
+
+        auto& node = *nodes.emplace_back(std::move(n));
+        slotOf(node.id) = &node;
+        appendToOrder(node.id);
+        recordChange(GraphChange::Type::NodeAdded, node.id);
+        return node;
+    }
+
+    // Downcast checked against the node kind instead of RTTI.
+    // Types without a nodeKind must be a base of every node in the graph, e.g. ExpressionNode.
+    template <typename T>
+    static T* cast(Node* node)
+    {
+        static_assert(std::is_base_of_v<Node, T>);
+
+        if constexpr (requires { T::nodeKind; })
+        {
+            if (!node || node->kind != T::nodeKind)
+            {
+                return nullptr;
+            }
+        }
+
+        return static_cast<T*>(node);
     }
 
     template <typename T>
     T* findNode(NodeId id)
     {
-        auto it = std::ranges::find_if(nodes, [&](auto& node) { return id == node->id; });
-        if (it == nodes.end())
+        const auto index = std::size_t{id.Get()};
+        if (index >= nodeSlots.size() || !nodeSlots[index])
         {
             return nullptr;
         }
 
-        return dynamic_cast<T*>(it->get());
+        return cast<T>(nodeSlots[index]);
     }
 
     template <typename T>
@@ -289,98 +419,532 @@ struct Graph
         return *ptr;
     }
 
-    void addLink(PinId in, PinId out)
+    // Refuses links that would close a cycle, the graph always stays a DAG
+    bool addLink(PinId in, PinId out)
     {
         LinkId link{out, in};
 
+        if (wouldCreateCycle(link.from().nodeId(), link.to().nodeId()))
+        {
+            return false;
+        }
+
         removeLinks(link.to());
 
-        links.emplace(link);
+        if (links.emplace(link).second)
+        {
+            indexLink(link);
+            reorderForEdge(link.from().nodeId(), link.to().nodeId());
+            recordChange(GraphChange::Type::LinkAdded, NodeId{0}, link);
+        }
+
+        return true;
     }
 
     void removeLink(LinkId id)
     {
-        auto it = std::find(links.begin(), links.end(), id);
-        if (it == links.end())
+        if (links.erase(id) > 0)
         {
-            return;
+            unindexLink(id);
+            recordChange(GraphChange::Type::LinkRemoved, NodeId{0}, id);
         }
-
-        it = links.erase(it);
     }
 
     void removeLinks(NodeId id)
     {
-        auto it = links.begin();
-        while (true)
+        // removeLink edits the list we are iterating
+        const auto linkList = getLinks(id);
+        const std::vector<LinkId> toRemove{linkList.begin(), linkList.end()};
+        for (const auto link : toRemove)
+        {
+            removeLink(link);
+        }
+    }
+
+    void removeLinks(PinId id)
+    {
+        const auto pinLinkList = getLinks(id);
+        const std::vector<LinkId> toRemove{pinLinkList.begin(), pinLinkList.end()};
+        for (const auto link : toRemove)
         {
-            it = std::find_if(it,
-                              links.end(),
-                              [&](const auto& link) { return id == link.from().nodeId() || id == link.to().nodeId(); });
-            if (it == links.end())
+            removeLink(link);
+        }
+    }
+
+    LinkId findLink(PinId id) const
+    {
+        const auto pinLinkList = getLinks(id);
+        return pinLinkList.empty() ? LinkId{0} : pinLinkList.front();
+    }
+
+    std::span<const LinkId> getLinks(NodeId id) const
+    {
+        const auto index = std::size_t{id.Get()};
+        return index < nodeLinks.size() ? std::span<const LinkId>{nodeLinks[index]} : std::span<const LinkId>{};
+    }
+
+    std::span<const LinkId> getLinks(PinId id) const
+    {
+        const auto index = std::size_t{id.nodeId().Get()};
+        if (index >= pinLinks.size())
+        {
+            return {};
+        }
+
+        const auto& pins = pinLinks[index];
+        const auto slot = pinSlot(id);
+        return slot < pins.size() ? std::span<const LinkId>{pins[slot]} : std::span<const LinkId>{};
+    }
+
+    // Replaces this graph with a deep copy of other. Ids are renumbered densely, like a save and reload would.
+    void copyFrom(const Graph& other)
+    {
+        nodes.clear();
+        links.clear();
+
+        std::vector<NodeId> newIds(other.idPool.capacity(), NodeId{0});
+        for (const auto& node : other.nodes)
+        {
+            if (!node)
             {
-                break;
+                continue;
             }
 
-            it = links.erase(it);
+            auto copy = node->clone(nodeArena);
+            copy->id = NodeId{static_cast<ShortId>(nodes.size() + 1)};
+            copy->positionDirty = true;
+
+            newIds[node->id.Get()] = copy->id;
+            nodes.push_back(std::move(copy));
         }
+
+        for (const auto link : other.links)
+        {
+            const auto from = link.from();
+            const auto to = link.to();
+            links.emplace(PinId::makeOutput(newIds[from.nodeId().Get()], from.index()),
+                          PinId::makeInput(newIds[to.nodeId().Get()], to.index()));
+        }
+
+        idPool.reset(static_cast<ShortId>(nodes.size()));
+
+        invalidateJournal();
+        rebuildNodeIndex();
+        rebuildLinkIndex();
     }
 
-    void removeLinks(PinId id)
+    // Needed after nodes is assigned directly, e.g. when deserialized
+    void rebuildNodeIndex()
     {
-        auto it = links.begin();
-        while (true)
+        nodeSlots.assign(idPool.capacity(), nullptr);
+
+        for (const auto& node : nodes)
         {
-            it = std::find_if(it, links.end(), [&](const auto& link) { return id == link.from() || id == link.to(); });
-            if (it == links.end())
+            if (node)
             {
-                break;
+                slotOf(node->id) = node.get();
             }
+        }
+    }
+
+    // Needed after links is assigned directly, e.g. when deserialized
+    void rebuildLinkIndex()
+    {
+        nodeLinks.clear();
+        pinLinks.clear();
 
-            it = links.erase(it);
+        for (const auto link : links)
+        {
+            indexLink(link);
         }
+
+        rebuildOrder();
     }
 
-    LinkId findLink(PinId id) const
+    // Position of the node in a topological order of the graph, producers come before their consumers
+    std::uint32_t orderOf(NodeId id) const
+    {
+        assert(id.Get() < nodeOrder.size());
+        return nodeOrder[id.Get()];
+    }
+
+    // root and the nodes upstream of it, producers first following the topological order. Producers `skip` returns
+    // true for are left out along with whatever only they lead to. No recursion, so the depth doesn't matter.
+    template <typename Skip>
+    std::vector<NodeId> collectUpstream(NodeId root, Skip&& skip) const
+    {
+        std::vector<NodeId> upstream{root};
+        std::unordered_set<NodeId> visited{root};
+
+        for (std::size_t x = 0; x < upstream.size(); x++)
+        {
+            const auto id = upstream[x];
+            for (const auto link : getLinks(id))
+            {
+                const auto producer = link.from().nodeId();
+                if (link.to().nodeId() == id && !skip(producer) && visited.insert(producer).second)
+                {
+                    upstream.push_back(producer);
+                }
+            }
+        }
+
+        std::ranges::sort(upstream, {}, [&](NodeId id) { return orderOf(id); });
+        return upstream;
+    }
+
+    // Whether a link from an output of `from` to an input of `to` would close a cycle.
+    // Only nodes ordered between the two are visited.
+    bool wouldCreateCycle(NodeId from, NodeId to) const
+    {
+        if (from == to)
+        {
+            return true;
+        }
+
+        if (orderOf(from) < orderOf(to))
+        {
+            return false;
+        }
+
+        return collectAffected(to, orderOf(from), PinDirection::Out, from).empty();
+    }
+
+    void removeNode(NodeId id)
     {
-        if (id.direction() == PinDirection::In)
+        if (!findNode<Node>(id))
         {
-            auto it = links.lower_bound(LinkId{NodeId{0}.makeOutput(0), id});
-            if (it != links.end() && it->to() == id)
+            return;
+        }
+
+        removeLinks(id);
+        slotOf(id) = nullptr;
+        orderSlots[orderOf(id)] = NodeId{0};
+
+        std::erase_if(nodes, [&](auto& node) { return id == node->id; });
+        idPool.release(id.Get());
+        recordChange(GraphChange::Type::NodeRemoved, id);
+    }
+
+    bool hasLink(LinkId link) const
+    {
+        return links.contains(link);
+    }
+
+    // Every structural change and node edit goes through here and bumps the revision
+    void recordChange(GraphChange::Type type, NodeId node, LinkId link = {})
+    {
+        journal.push_back({++currentRevision, type, node, link});
+
+        // Drops the oldest half, unless a consumer retaining the journal hasn't read it yet
+        if (journal.size() > maxJournalSize)
+        {
+            const auto half = journal.size() / 2;
+            if (journal[half - 1].revision <= retainedRevision)
             {
-                return *it;
+                journal.erase(journal.begin(), journal.begin() + half);
             }
         }
-        else
+    }
+
+    // Keeps every change after `since` however long the journal grows, for a consumer that can't rebuild from
+    // scratch when it misses some. Pass no revision to let the journal be trimmed again.
+    void retainJournal(std::uint64_t since = std::numeric_limits<std::uint64_t>::max())
+    {
+        retainedRevision = since;
+    }
+
+    // Drops the journal, consumers see a gap and rebuild from scratch. Used when nodes/links are replaced wholesale.
+    void invalidateJournal()
+    {
+        journal.clear();
+        currentRevision++;
+    }
+
+    std::uint64_t revision() const
+    {
+        return currentRevision;
+    }
+
+    // Changes recorded after `since`, or nullopt when some of them are no longer in the journal
+    std::optional<std::span<const GraphChange>> changesSince(std::uint64_t since) const
+    {
+        if (since > currentRevision)
+        {
+            return std::nullopt;
+        }
+
+        if (since == currentRevision)
         {
-            auto it = std::ranges::find_if(links, [&](auto& link) { return link.from() == id; });
-            if (it != links.end())
+            return std::span<const GraphChange>{};
+        }
+
+        if (journal.empty() || since + 1 < journal.front().revision)
+        {
+            return std::nullopt;
+        }
+
+        return std::span<const GraphChange>{journal}.subspan(since + 1 - journal.front().revision);
+    }
+
+private:
+    static constexpr std::size_t maxJournalSize = 4096;
+
+    std::uint64_t currentRevision{};
+    std::uint64_t retainedRevision = std::numeric_limits<std::uint64_t>::max();
+    std::vector<GraphChange> journal;
+
+    // Topological order maintained incrementally (Pearce-Kelly): nodeOrder maps a node id to its position,
+    // orderSlots maps positions back to nodes, removed nodes leave a 0 hole until the next compaction
+    std::vector<std::uint32_t> nodeOrder;
+    std::vector<NodeId> orderSlots;
+
+    // Ids are kept dense by the pool so per node tables are flat vectors indexed by id.
+    // Nodes are heap allocated so their address is stable for the lifetime of the node.
+    std::vector<Node*> nodeSlots;
+
+    // Adjacency index over links, every link is listed under both its nodes and both its pins.
+    // Pins are found by node id, then by pinSlot() within the node, both flat like the tables above.
+    std::vector<std::vector<LinkId>> nodeLinks;
+    std::vector<std::vector<std::vector<LinkId>>> pinLinks;
+
+    void indexLink(LinkId link)
+    {
+        const auto from = link.from();
+        const auto to = link.to();
+
+        linksOf(from.nodeId()).push_back(link);
+        if (to.nodeId() != from.nodeId())
+        {
+            linksOf(to.nodeId()).push_back(link);
+        }
+
+        linksOf(from).push_back(link);
+        linksOf(to).push_back(link);
+    }
+
+    void unindexLink(LinkId link)
+    {
+        std::erase(linksOf(link.from().nodeId()), link);
+        std::erase(linksOf(link.to().nodeId()), link);
+        std::erase(linksOf(link.from()), link);
+        std::erase(linksOf(link.to()), link);
+    }
+
+    void appendToOrder(NodeId id)
+    {
+        if (orderSlots.size() > 2 * nodes.size() + 64)
+        {
+            std::erase(orderSlots, NodeId{0});
+            for (std::uint32_t position = 0; position < orderSlots.size(); position++)
             {
-                return *it;
+                growToFit(nodeOrder, orderSlots[position]) = position;
             }
         }
 
-        return LinkId{0};
+        growToFit(nodeOrder, id) = static_cast<std::uint32_t>(orderSlots.size());
+        orderSlots.push_back(id);
     }
 
-    void removeNode(NodeId id)
+    // Nodes reachable from start, following links in the given direction, whose position is within bound.
+    // Returns an empty list if stopAt is reached.
+    std::vector<NodeId> collectAffected(NodeId start, std::uint32_t bound, PinDirection direction, NodeId stopAt) const
+    {
+        const bool forward = direction == PinDirection::Out;
+        const auto inBound = [&](NodeId id) { return forward ? orderOf(id) <= bound : orderOf(id) >= bound; };
+
+        std::vector<NodeId> affected{start};
+        std::unordered_set<NodeId> visited{start};
+
+        for (std::size_t x = 0; x < affected.size(); x++)
+        {
+            const auto id = affected[x];
+            for (const auto link : getLinks(id))
+            {
+                const auto self = forward ? link.from() : link.to();
+                if (self.nodeId() != id)
+                {
+                    continue;
+                }
+
+                const auto next = forward ? link.to().nodeId() : link.from().nodeId();
+                if (next == stopAt)
+                {
+                    return {};
+                }
+
+                if (inBound(next) && visited.insert(next).second)
+                {
+                    affected.push_back(next);
+                }
+            }
+        }
+
+        return affected;
+    }
+
+    // Called after adding the edge from -> to, only touches nodes ordered between the two
+    void reorderForEdge(NodeId from, NodeId to)
     {
-        auto it = std::ranges::find_if(nodes, [&](auto& node) { return id == node->id; });
-        if (it == nodes.end())
+        const auto lowerBound = orderOf(to);
+        const auto upperBound = orderOf(from);
+        if (upperBound < lowerBound)
         {
             return;
         }
 
-        auto& node = **it;
+        auto forwardNodes = collectAffected(to, upperBound, PinDirection::Out, from);
+        auto backwardNodes = collectAffected(from, lowerBound, PinDirection::In, to);
+        assert(!forwardNodes.empty() && !backwardNodes.empty());
 
-        removeLinks(id);
+        const auto byOrder = [&](NodeId a, NodeId b) { return orderOf(a) < orderOf(b); };
+        std::ranges::sort(forwardNodes, byOrder);
+        std::ranges::sort(backwardNodes, byOrder);
 
-        nodes.erase(it);
+        std::vector<std::uint32_t> positions;
+        positions.reserve(forwardNodes.size() + backwardNodes.size());
+        for (const auto id : backwardNodes)
+        {
+            positions.push_back(orderOf(id));
+        }
+        for (const auto id : forwardNodes)
+        {
+            positions.push_back(orderOf(id));
+        }
+        std::ranges::sort(positions);
+
+        // Everything upstream of `from` keeps its relative order and moves ahead of everything downstream of `to`
+        std::size_t next = 0;
+        const auto place = [&](const std::vector<NodeId>& group)
+        {
+            for (const auto id : group)
+            {
+                nodeOrder[id.Get()] = positions[next];
+                orderSlots[positions[next]] = id;
+                next++;
+            }
+        };
+
+        place(backwardNodes);
+        place(forwardNodes);
     }
 
-    bool hasLink(LinkId link)
+    // Full rebuild by depth first search, links closing a cycle (possible in old files) are dropped
+    void rebuildOrder()
     {
-        return std::ranges::contains(links, link);
+        enum class Mark : std::uint8_t
+        {
+            None,
+            Active,
+            Done
+        };
+
+        std::vector<Mark> marks(idPool.capacity(), Mark::None);
+        std::vector<NodeId> postOrder;
+        std::vector<LinkId> backLinks;
+
+        for (const auto& root : nodes)
+        {
+            if (!root || marks[root->id.Get()] != Mark::None)
+            {
+                continue;
+            }
+
+            std::vector<std::pair<NodeId, std::size_t>> stack{{root->id, 0}};
+            marks[root->id.Get()] = Mark::Active;
+
+            while (!stack.empty())
+            {
+                const auto [id, linkIndex] = stack.back();
+                const auto nodeLinkList = getLinks(id);
+
+                auto nextLinkIndex = linkIndex;
+                while (nextLinkIndex < nodeLinkList.size() && nodeLinkList[nextLinkIndex].from().nodeId() != id)
+                {
+                    nextLinkIndex++;
+                }
+
+                if (nextLinkIndex == nodeLinkList.size())
+                {
+                    marks[id.Get()] = Mark::Done;
+                    postOrder.push_back(id);
+                    stack.pop_back();
+                    continue;
+                }
+
+                stack.back().second = nextLinkIndex + 1;
+
+                const auto link = nodeLinkList[nextLinkIndex];
+                const auto next = link.to().nodeId();
+                if (next.Get() >= marks.size())
+                {
+                    continue;
+                }
+
+                if (marks[next.Get()] == Mark::Active)
+                {
+                    backLinks.push_back(link);
+                }
+                else if (marks[next.Get()] == Mark::None)
+                {
+                    marks[next.Get()] = Mark::Active;
+                    stack.push_back({next, 0});
+                }
+            }
+        }
+
+        for (const auto link : backLinks)
+        {
+            removeLink(link);
+        }
+
+        orderSlots.assign(postOrder.rbegin(), postOrder.rend());
+        nodeOrder.assign(idPool.capacity(), 0);
+        for (std::uint32_t position = 0; position < orderSlots.size(); position++)
+        {
+            nodeOrder[orderSlots[position].Get()] = position;
+        }
+    }
+
+    template <typename Table>
+    static typename Table::reference growToFit(Table& table, NodeId id)
+    {
+        const auto index = std::size_t{id.Get()};
+        if (index >= table.size())
+        {
+            table.resize(index + 1);
+        }
+
+        return table[index];
+    }
+
+    Node*& slotOf(NodeId id)
+    {
+        return growToFit(nodeSlots, id);
+    }
+
+    std::vector<LinkId>& linksOf(NodeId id)
+    {
+        return growToFit(nodeLinks, id);
+    }
+
+    // Inputs and outputs interleaved, so a node only has as many slots as its highest linked pin needs
+    static std::size_t pinSlot(PinId id)
+    {
+        return std::size_t{id.index()} * 2 + (id.direction() == PinDirection::Out);
+    }
+
+    std::vector<LinkId>& linksOf(PinId id)
+    {
+        auto& pins = growToFit(pinLinks, id.nodeId());
+
+        const auto slot = pinSlot(id);
+        if (slot >= pins.size())
+        {
+            pins.resize(slot + 1);
+        }
+
+        return pins[slot];
     }
 };
 
@@ -1,24 +1,104 @@
 #pragma once
 
-//TODO: add a actual pool
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <vector>
 
+// Hands out ids starting at 1 and reuses released ones, oldest first so a freed id isn't handed back right away.
+// Every release bumps the id's generation, a Handle taken before that no longer matches.
 template <typename T>
 struct IdPool
 {
+    struct Handle
+    {
+        T id{};
+        std::uint32_t generation{};
+    };
+
     T take()
     {
-        return ++next;
+        if (!freeIds.empty())
+        {
+            const auto id = freeIds.front();
+            freeIds.pop_front();
+            return id;
+        }
+
+        generations.resize(++next + 1);
+        return next;
     }
 
     void release(T t)
     {
+        assert(t > 0 && t <= next);
+
+        generations[t]++;
+        freeIds.push_back(t);
+    }
+
+    // Takes back a specific id, e.g. to restore a removed node under its old id. False when it's still taken.
+    [[nodiscard]] bool claim(T t)
+    {
+        if (t == 0)
+        {
+            return false;
+        }
+
+        if (t > next)
+        {
+            for (T id = next + 1; id < t; id++)
+            {
+                freeIds.push_back(id);
+            }
+
+            next = t;
+            generations.resize(next + 1);
+            return true;
+        }
+
+        const auto it = std::find(freeIds.begin(), freeIds.end(), t);
+        if (it == freeIds.end())
+        {
+            return false;
+        }
+
+        freeIds.erase(it);
+        return true;
+    }
+
+    // Every id in [1, last] counts as taken, nothing is free
+    void reset(T last)
+    {
+        next = last;
+        freeIds.clear();
+        generations.assign(next + 1, 0);
+    }
+
+    // One past the largest id handed out, for tables indexed by id
+    std::size_t capacity() const
+    {
+        return std::size_t{next} + 1;
+    }
+
+    std::uint32_t generation(T t) const
+    {
+        return t < generations.size() ? generations[t] : 0;
+    }
+
+    Handle makeHandle(T t) const
+    {
+        return {t, generation(t)};
     }
 
-    void reset(T newNext)
+    bool isCurrent(const Handle& handle) const
     {
-        next = newNext;
+        return generation(handle.id) == handle.generation;
     }
 
 private:
     T next{};
-};
\ No newline at end of file
+    std::deque<T> freeIds;
+    std::vector<std::uint32_t> generations{0};
+};
@@ -178,9 +178,28 @@ bool mapListBox(std::string name, MapListBoxData& data, std::unordered_map<std::
         hasChange = true;
     }
 
-    for (const auto& toCopy : toCopyList)
+    // Duplicates first, a renamed item is then moved since it gets removed anyway
+    for (const auto& [to, from] : toCopyList)
     {
-        map[toCopy.first] = map[toCopy.second];
+        if (!toRemoveList.contains(from))
+        {
+            if constexpr (std::is_copy_assignable_v<T>)
+            {
+                map[to] = map[from];
+            }
+            else
+            {
+                map[to] = map[from].duplicate();
+            }
+        }
+    }
+
+    for (const auto& [to, from] : toCopyList)
+    {
+        if (toRemoveList.contains(from))
+        {
+            map[to] = std::move(map[from]);
+        }
     }
 
     for (const auto& toRemove : toRemoveList)
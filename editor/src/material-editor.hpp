@@ -45,7 +45,9 @@
 #include "nodes/random.hpp"
 #include "nodes/code.hpp"
 #include "nodes/noise.hpp"
+#include "nodes/register-archetypes.hpp"
 #include "preview.hpp"
+#include "profiler.hpp"
 #include "shortcuts.hpp"
 #include "value.hpp"
 
@@ -57,6 +59,7 @@
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <optional>
 #include <ranges>
 #include <unordered_map>
 #include <variant>
@@ -73,7 +76,7 @@ struct ProjectEditor
 
     MaterialRepo materialRepo;
 
-    std::unordered_map<std::string, MaterialTab> materialTabs;
+    std::unordered_map<std::string, LazyMaterialTab> materialTabs;
     TextureReferenceMap textureReferences;
 
     std::vector<std::string> openTabs;
@@ -90,6 +93,15 @@ struct ProjectEditor
     sf::Clock clock;
     float runningTime{};
 
+    // Frames still drawn after the last input, ImGui needs a few to settle hover states, popups and layout
+    static constexpr int settleFrameCount = 3;
+    int settleFrames = settleFrameCount;
+
+    // An idle editor still redraws this often, for the text cursor blink and hover tooltips
+    static constexpr sf::Time idleRedrawInterval = sf::milliseconds(500);
+
+    std::optional<sf::Event> pendingEvent;
+
     Preview preview;
 
     Shortcuts shortcuts;
@@ -178,31 +190,22 @@ struct ProjectEditor
                       }},
                      {"Edit",
                       {
+                          Shortcut{[&] { onUndo(); }, "Undo", Key::Z, Shortcut::Modifier::Ctrl},
+                          Shortcut{[&] { onRedo(); }, "Redo", Key::Y, Shortcut::Modifier::Ctrl},
                           Shortcut{[&] { onCut(); }, "Cut", Key::X, Shortcut::Modifier::Ctrl},
                           Shortcut{[&] { onCopy(); }, "Copy", Key::C, Shortcut::Modifier::Ctrl},
                           Shortcut{[&] { onPaste(); }, "Paste", Key::V, Shortcut::Modifier::Ctrl},
                       }}};
+
+#ifdef MLSE_PROFILER
+        shortcuts["View"].push_back(
+            Shortcut{[&] { Profiler::get().showOverlay = !Profiler::get().showOverlay; }, "Profiler", Key::F3, 0});
+#endif
     }
 
     void initArchetypes()
     {
-        VecValueNode::registerArchetypes(archetypes);
-        ScalarValueNode::registerArchetypes(archetypes);
-        MakeVecNode::registerArchetypes(archetypes);
-        BreakVecNode::registerArchetypes(archetypes);
-        InputNode::registerArchetypes(archetypes);
-        OutputNode::registerArchetypes(archetypes);
-        BinaryOpNode::registerArchetypes(archetypes);
-        BuiltinFuncNode::registerArchetypes(archetypes);
-        BridgeNode::registerArchetypes(archetypes);
-        AppendNode::registerArchetypes(archetypes);
-        ParameterNode::registerArchetypes(archetypes);
-        SampleTextureNode::registerArchetypes(archetypes);
-        RandomNode::registerArchetypes(archetypes);
-        CodeNode::registerArchetypes(archetypes);
-        NoiseNode::registerArchetypes(archetypes);
-
-        NodeSerializer::repo = &archetypes;
+        registerAllArchetypes(archetypes);
     }
 
     void onMaterialTabChange(const std::string& newId)
@@ -234,7 +237,7 @@ struct ProjectEditor
             return nullptr;
         }
 
-        return &it->second;
+        return &it->second.get(archetypes);
     }
 
     std::optional<std::string> getProjectPath() const
@@ -437,6 +440,22 @@ struct ProjectEditor
         selectedMaterialTab = {};
     }
 
+    void onUndo()
+    {
+        if (auto* tab = getCurrentTab())
+        {
+            tab->graphEditor.undo();
+        }
+    }
+
+    void onRedo()
+    {
+        if (auto* tab = getCurrentTab())
+        {
+            tab->graphEditor.redo();
+        }
+    }
+
     void onCut()
     {
         if (auto* tab = getCurrentTab())
@@ -462,22 +481,38 @@ struct ProjectEditor
         }
     }
 
-    void serialize(Serializer& s)
+    // Open tabs are needed right away so they are deserialized in parallel, the others stay lazy.
+    void loadOpenTabs()
     {
-        NodeSerializer::repo = &archetypes;
+        std::vector<LazyMaterialTab*> tabs;
+        for (const auto& tabId : openTabs)
+        {
+            if (const auto it = materialTabs.find(tabId); it != materialTabs.end())
+            {
+                tabs.push_back(&it->second);
+            }
+        }
+
+        LazyMaterialTab::loadAll(tabs, archetypes);
+    }
 
+    void serialize(Serializer& s)
+    {
         s.serialize("materials", materialTabs);
         s.serialize("openTabs", openTabs);
         s.serialize("textureReferences", textureReferences);
 
         if (!s.isSaving)
         {
+            loadOpenTabs();
             updateTextures();
         }
     }
 
     std::optional<std::string> serializeToString()
     {
+        PROFILE_SCOPE("serializeToString");
+
         try
         {
             json j;
@@ -493,6 +528,8 @@ struct ProjectEditor
 
     bool serializeFromString(const std::string& data)
     {
+        PROFILE_SCOPE("serializeFromString");
+
         try
         {
             clear();
@@ -508,49 +545,75 @@ struct ProjectEditor
         return false;
     }
 
+#ifdef MLSE_TRACING
+    bool saveTrace()
+    {
+        if (const auto path = FileUtils::browseFile(true, FileUtils::TraceFilter))
+        {
+            return FileUtils::writeFile(*path, TraceRecorder::get().toJson());
+        }
+
+        return false;
+    }
+#endif
+
+    // Handles the event the idle wait returned first, then whatever else is queued
     void processEvents()
     {
+        if (pendingEvent)
+        {
+            handleEvent(*pendingEvent);
+            pendingEvent.reset();
+            settleFrames = settleFrameCount;
+        }
+
         while (const auto event = window.pollEvent())
         {
-            ImGui::SFML::ProcessEvent(window, *event);
+            handleEvent(*event);
+            settleFrames = settleFrameCount;
+        }
+    }
 
-            if (auto* e = event->getIf<sf::Event::Closed>())
-            {
-                window.close();
-            }
-            else if (auto* e = event->getIf<sf::Event::Resized>())
+    void handleEvent(const sf::Event& event)
+    {
+        ImGui::SFML::ProcessEvent(window, event);
+
+        if (auto* e = event.getIf<sf::Event::Closed>())
+        {
+            window.close();
+        }
+        else if (auto* e = event.getIf<sf::Event::Resized>())
+        {
+            auto size = static_cast<sf::Vector2f>(e->size);
+            window.setView({size / 2, size});
+        }
+        else if (auto* e = event.getIf<sf::Event::KeyPressed>())
+        {
+            if (ImGui::GetIO().WantCaptureKeyboard)
             {
-                auto size = static_cast<sf::Vector2f>(e->size);
-                window.setView({size / 2, size});
+                return;
             }
-            else if (auto* e = event->getIf<sf::Event::KeyPressed>())
-            {
-                if (ImGui::GetIO().WantCaptureKeyboard)
-                {
-                    continue;
-                }
 
-                for (auto& [_, shortcuts] : shortcuts)
+            for (auto& [_, shortcuts] : shortcuts)
+            {
+                for (auto& shortcut : shortcuts)
                 {
-                    for (auto& shortcut : shortcuts)
+                    if (shortcut.matchesEvent(*e))
                     {
-                        if (shortcut.matchesEvent(*e))
-                        {
-                            shortcut.callback();
-                        }
+                        shortcut.callback();
                     }
                 }
+            }
 
-                if (e->code == sf::Keyboard::Key::Y)
-                {
-                    //UEGraphAdapter::CurrentGraph = &graph;
+            if (e->code == sf::Keyboard::Key::Y)
+            {
+                //UEGraphAdapter::CurrentGraph = &graph;
 
-                    //FFormatter formatter;
-                    //formatter.Format();
+                //FFormatter formatter;
+                //formatter.Format();
 
-                    //Formatter formatter{ &graph };
-                    //formatter.format();
-                }
+                //Formatter formatter{ &graph };
+                //formatter.format();
             }
         }
     }
@@ -560,6 +623,7 @@ struct ProjectEditor
         if (auto* tab = getCurrentTab())
         {
             tab->materialInstance->setValue("time", runningTime);
+            tab->graphEditor.history.memoryBudget = std::size_t(configs.undoMemoryBudgetMB) * 1024 * 1024;
             tab->update(textureReferences);
             tab->draw();
 
@@ -657,6 +721,8 @@ struct ProjectEditor
 
     void updateTexture(const std::string& id)
     {
+        PROFILE_SCOPE("updateTexture");
+
         auto& textureReference = textureReferences[id];
         textureReference.preview = {};
 
@@ -670,9 +736,13 @@ struct ProjectEditor
             textureReference.preview.loadFromMemory(textureData.data(), textureData.size());
         }
 
-        for (auto& [id, tab] : materialTabs)
+        for (auto& [id, lazyTab] : materialTabs)
         {
-            tab.isMaterialDirty = true;
+            // Tabs that aren't loaded yet get marked dirty when they are deserialized
+            if (auto* tab = lazyTab.getIfLoaded())
+            {
+                tab->isMaterialDirty = true;
+            }
         }
     }
 
@@ -825,6 +895,25 @@ struct ProjectEditor
                 }
             }
 
+#ifdef MLSE_TRACING
+            if (ImGui::BeginMenu("Trace"))
+            {
+                auto& recorder = TraceRecorder::get();
+
+                if (ImGui::MenuItem("Record", nullptr, recorder.isRecording()))
+                {
+                    recorder.setRecording(!recorder.isRecording());
+                }
+
+                if (ImGui::MenuItem("Save Trace..", nullptr, false, recorder.eventCount() > 0))
+                {
+                    saveTrace();
+                }
+
+                ImGui::EndMenu();
+            }
+#endif
+
             ImGui::EndMenuBar();
         }
 
@@ -978,27 +1067,102 @@ struct ProjectEditor
         ImGui::PopStyleVar(1);
     }
 
-    void update()
+    void updateFrame()
     {
-        while (window.isOpen())
+        PROFILE_SCOPE("Frame");
+
         {
+            PROFILE_SCOPE("processEvents");
             processEvents();
+        }
+
+        const auto deltaTime = clock.restart();
+        runningTime += deltaTime.asSeconds();
+        ImGui::SFML::Update(window, deltaTime);
 
-            const auto deltaTime = clock.restart();
-            runningTime += deltaTime.asSeconds();
-            ImGui::SFML::Update(window, deltaTime);
+        drawMainWindow();
 
-            drawMainWindow();
+#ifdef MLSE_PROFILER
+        Profiler::get().drawOverlay();
+#endif
 
-            /*
-			ImGui::Begin("Dear ImGui Style Editor", nullptr);
-			ImGui::ShowStyleEditor();
-			ImGui::End();
-			*/
+        /*
+		ImGui::Begin("Dear ImGui Style Editor", nullptr);
+		ImGui::ShowStyleEditor();
+		ImGui::End();
+		*/
 
-            window.clear();
+        window.clear();
+        {
+            PROFILE_SCOPE("ImGui::SFML::Render");
             ImGui::SFML::Render(window);
-            window.display();
+        }
+        window.display();
+    }
+
+    // Something changes on screen without input: a widget or the mouse is held, or the node editor animates
+    bool isInteracting()
+    {
+        if (ImGui::IsAnyItemActive() || ImGui::IsAnyMouseDown())
+        {
+            return true;
+        }
+
+        const auto* tab = getCurrentTab();
+        return tab && tab->isEditorAnimating();
+    }
+
+    // Blocks until the next frame is due. That is right away while settling after input or interacting, at the
+    // frame cap while the preview animates, and otherwise on the next input or the idle redraw.
+    void waitForNextFrame()
+    {
+        if (settleFrames > 0)
+        {
+            settleFrames--;
+            return;
+        }
+
+        if (isInteracting())
+        {
+            return;
+        }
+
+        auto timeout = idleRedrawInterval;
+
+        const auto* tab = getCurrentTab();
+        if (tab && tab->usesTime)
+        {
+            if (configs.animatedFrameCap <= 0)
+            {
+                return;
+            }
+
+            // The clock was restarted at the start of the previous frame
+            timeout = sf::seconds(1.f / configs.animatedFrameCap) - clock.getElapsedTime();
+            if (timeout <= sf::Time::Zero)
+            {
+                return;
+            }
+        }
+
+        PROFILE_SCOPE("Idle");
+        pendingEvent = window.waitEvent(timeout);
+    }
+
+    void update()
+    {
+        while (window.isOpen())
+        {
+#ifdef MLSE_PROFILER
+            Profiler::get().beginFrame();
+#endif
+
+            waitForNextFrame();
+            updateFrame();
+
+#ifdef MLSE_PROFILER
+            Profiler::get().endFrame();
+#endif
         }
     }
 };
\ No newline at end of file
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "ImGuiColorTextEdit/TextEditor.h"
 #include "graph-editor.hpp"
 #include "mls/material.hpp"
+#include "parallel-utils.hpp"
+#include "profiler.hpp"
 
+#include <chrono>
 #include <memory>
+#include <span>
 
 struct EditorTextureReference : TextureReference
 {
@@ -50,11 +55,11 @@ EditorContextPtr makeEditorContext()
 
 struct MaterialTab
 {
-    ArchetypeRepo& archetypes = *NodeSerializer::repo;
+    ArchetypeRepo& archetypes;
 
     Graph graph;
     GraphContext graphContext;
-    EditorContextPtr edContext = makeEditorContext();
+    EditorContextPtr edContext;
 
     GraphEditor graphEditor{graph, graphContext, archetypes};
 
@@ -63,41 +68,81 @@ struct MaterialTab
 
     bool isMaterialDirty{};
 
+    // Code is only generated again when the graph revision or the parameter types moved on
+    std::uint64_t generatedRevision{};
+    bool isCodeDirty = true;
+
+    // While a value is being dragged, code is generated at most this often
+    std::chrono::milliseconds codegenDebounce{100};
+    std::chrono::steady_clock::time_point lastCodegenTime;
+
+    // Nodes the last code generation evaluated, the next one clears those it doesn't reach anymore
+    std::unordered_set<NodeId> evaluatedNodes;
+
     std::string vertexCode;
     std::string fragmentCode;
 
+    // The generated shader reads the time uniform, so the preview changes every frame
+    bool usesTime{};
+
     std::unordered_map<std::string, std::string> parameterToTextureReference;
 
     MapListBoxData parametersListBox;
 
-    MaterialTab() = default;
+    explicit MaterialTab(ArchetypeRepo& archetypes) : archetypes{archetypes}
+    {
+    }
 
-    MaterialTab(const MaterialTab& other)
+    MaterialTab(const MaterialTab& other) : MaterialTab{other.archetypes}
     {
         *this = other;
     }
 
     MaterialTab(MaterialTab&&) = delete;
 
+    // Copies what serialize would save, without going through json. The editor context stays ours,
+    // everything it mirrors (view, node positions) is pushed to it again.
     MaterialTab& operator=(const MaterialTab& other)
     {
-        json j;
+        if (this == &other)
+        {
+            return *this;
+        }
 
-        Serializer saver(true, j);
-        const_cast<MaterialTab&>(other).serialize(saver);
+        graph.copyFrom(other.graph);
+        graphEditor.copyStateFrom(other.graphEditor);
+        evaluatedNodes.clear();
 
-        Serializer loader(false, j);
-        serialize(loader);
+        materialTemplate.parameters = other.materialTemplate.parameters;
+        parameterToTextureReference = other.parameterToTextureReference;
+
+        isMaterialDirty = true;
+        isCodeDirty = true;
 
         return *this;
     }
 
     MaterialTab& operator=(MaterialTab&&) = delete;
 
-    void serialize(Serializer s)
+    // The editor context is created on first use, serialization never touches it
+    void attachEditorContext()
     {
+        if (!edContext)
+        {
+            edContext = makeEditorContext();
+        }
+
         ed::SetCurrentEditor(edContext.get());
+    }
+
+    // The node editor is still playing an animation, e.g. navigating to content
+    bool isEditorAnimating() const
+    {
+        return edContext && reinterpret_cast<ax::NodeEditor::Detail::EditorContext*>(edContext.get())->HasLiveAnimations();
+    }
 
+    void serialize(Serializer s)
+    {
         s.serialize(graphEditor);
         s.serialize("parameters", materialTemplate.parameters);
         s.serialize("parameterToTextureReference", parameterToTextureReference);
@@ -105,6 +150,8 @@ struct MaterialTab
         if (!s.isSaving)
         {
             isMaterialDirty = true;
+            isCodeDirty = true;
+            evaluatedNodes.clear();
         }
     }
 
@@ -128,11 +175,12 @@ struct MaterialTab
 
                 for (auto& node : graph.nodes)
                 {
-                    if (auto* parameterNode = dynamic_cast<ParameterNode*>(node.get()))
+                    if (auto* parameterNode = Graph::cast<ParameterNode>(node.get()))
                     {
                         if (parameterNode->parameterId == oldName)
                         {
                             parameterNode->parameterId = newName;
+                            graph.recordChange(GraphChange::Type::ParameterBindingChanged, parameterNode->id);
                         }
                     }
                 }
@@ -240,23 +288,73 @@ struct MaterialTab
 
     void draw()
     {
-        ed::SetCurrentEditor(edContext.get());
+        attachEditorContext();
 
         graphEditor.draw();
     }
 
     void update(const TextureReferenceMap& textureReferences)
     {
-        ed::SetCurrentEditor(edContext.get());
+        attachEditorContext();
 
-        graphContext.parameterTypes.clear();
+        ParameterTypeMap parameterTypes;
         for (const auto& [id, parameter] : materialTemplate.parameters)
         {
-            graphContext.parameterTypes[id] = getParameterValueType(parameter.defaultValue);
+            parameterTypes[id] = getParameterValueType(parameter.defaultValue);
+        }
+
+        if (parameterTypes != graphContext.parameterTypes)
+        {
+            graphContext.parameterTypes = std::move(parameterTypes);
+            graphEditor.markContextChanged();
+            isCodeDirty = true;
         }
 
         graphEditor.update();
 
+        if (needsCodegen())
+        {
+            generateCode();
+        }
+
+        if (isMaterialDirty)
+        {
+            isMaterialDirty = false;
+
+            for (const auto& pair : parameterToTextureReference)
+            {
+                const auto it = textureReferences.find(pair.second);
+                if (it != textureReferences.end())
+                {
+                    materialInstance->setValue(pair.first, &it->second.preview);
+                }
+            }
+
+            PROFILE_SCOPE("Shader compile");
+            materialTemplate.setSource(vertexCode, fragmentCode);
+        }
+    }
+
+    bool needsCodegen() const
+    {
+        if (!isCodeDirty && generatedRevision == graph.revision())
+        {
+            return false;
+        }
+
+        // Dragging a field edits the graph every frame, the final value is generated once the drag ends
+        const bool isDragging = ImGui::IsAnyItemActive() && ImGui::IsMouseDown(ImGuiMouseButton_Left);
+        return !isDragging || std::chrono::steady_clock::now() - lastCodegenTime >= codegenDebounce;
+    }
+
+    void generateCode()
+    {
+        PROFILE_SCOPE("MaterialTab::generateCode");
+
+        isCodeDirty = false;
+        generatedRevision = graph.revision();
+        lastCodegenTime = std::chrono::steady_clock::now();
+
         CodeGenerator vertexGen(graph, CodeGenerator::Type::Vertex);
         CodeGenerator fragmentGen(graph, CodeGenerator::Type::Fragment);
 
@@ -267,7 +365,7 @@ struct MaterialTab
                 continue;
             }
 
-            if (auto* n = dynamic_cast<OutputNode*>(node.get()))
+            if (auto* n = Graph::cast<OutputNode>(node.get()))
             {
                 if (n->type == CodeGenerator::Type::Vertex)
                 {
@@ -280,6 +378,26 @@ struct MaterialTab
             }
         }
 
+        // Evaluation only resets the nodes it visits, the ones cut off from the outputs would keep their values,
+        // errors and red links
+        for (const auto id : evaluatedNodes)
+        {
+            auto* node = graph.findNode<ExpressionNode>(id);
+            if (node && !vertexGen.evaluatedNodes.contains(id) && !fragmentGen.evaluatedNodes.contains(id))
+            {
+                node->resetEvaluation();
+            }
+        }
+
+        evaluatedNodes = vertexGen.evaluatedNodes;
+        evaluatedNodes.insert(fragmentGen.evaluatedNodes.begin(), fragmentGen.evaluatedNodes.end());
+
+        vertexGen.eliminateDeadCode();
+        fragmentGen.eliminateDeadCode();
+
+        const auto timeUniform = std::format("{}time", Material::uniformPrefix);
+        usesTime = vertexGen.shaderInputs.contains(timeUniform) || fragmentGen.shaderInputs.contains(timeUniform);
+
         auto newVertexCode = vertexGen.finalize();
         auto newFragmentCode = fragmentGen.finalize();
         if (vertexCode != newVertexCode || fragmentCode != newFragmentCode)
@@ -289,26 +407,128 @@ struct MaterialTab
 
             isMaterialDirty = true;
         }
+    }
+};
 
-        if (isMaterialDirty)
+void serialize(Serializer& s, MaterialTab& tab)
+{
+    tab.serialize(s);
+}
+
+// Holds a material as its raw serialized sub-document until something actually needs the MaterialTab.
+// Opening a project then only costs the json parse, graphs, editor contexts and code editors are built on first use.
+struct LazyMaterialTab
+{
+    LazyMaterialTab() = default;
+
+    // Move only, copying would deep clone the whole graph, see duplicate() for when that is wanted
+    LazyMaterialTab(LazyMaterialTab&&) = default;
+    LazyMaterialTab& operator=(LazyMaterialTab&&) = default;
+
+    // A loaded tab is copied structurally, see MaterialTab's copy. One never loaded only has its json to copy,
+    // and the copy stays lazy until it is opened.
+    LazyMaterialTab duplicate() const
+    {
+        LazyMaterialTab copy;
+        if (tab)
         {
-            isMaterialDirty = false;
+            copy.tab = std::make_unique<MaterialTab>(*tab);
+        }
+        else
+        {
+            copy.data = data;
+        }
+        return copy;
+    }
 
-            for (const auto& pair : parameterToTextureReference)
+    bool isLoaded() const
+    {
+        return tab != nullptr;
+    }
+
+    // Builds the MaterialTab without touching ImGui or the node editor, safe to call from a worker thread
+    void load(ArchetypeRepo& archetypes)
+    {
+        if (tab)
+        {
+            return;
+        }
+
+        PROFILE_SCOPE("LazyMaterialTab::load");
+
+        tab = std::make_unique<MaterialTab>(archetypes);
+
+        if (!data.is_null())
+        {
+            Serializer loader(false, data);
+            tab->serialize(loader);
+        }
+
+        data = {};
+    }
+
+    MaterialTab& get(ArchetypeRepo& archetypes)
+    {
+        load(archetypes);
+
+        return *tab;
+    }
+
+    // Loads every tab in parallel, each tab only touches its own state
+    static void loadAll(std::span<LazyMaterialTab* const> tabs, ArchetypeRepo& archetypes)
+    {
+        // TextEditor builds its language definitions on first use without any locking, and every code node
+        // constructs one, so build them before the workers can race on it
+        TextEditor::LanguageDefinition::HLSL();
+        TextEditor::LanguageDefinition::GLSL();
+
+        ParallelUtils::forEachIndex(tabs.size(), [&](std::size_t index) { tabs[index]->load(archetypes); });
+    }
+
+    MaterialTab* getIfLoaded()
+    {
+        return tab.get();
+    }
+
+    json getData() const
+    {
+        if (tab)
+        {
+            json j;
+            Serializer saver(true, j);
+            tab->serialize(saver);
+            return j;
+        }
+
+        return data;
+    }
+
+    void serialize(Serializer& s)
+    {
+        if (s.isSaving)
+        {
+            if (tab)
             {
-                const auto it = textureReferences.find(pair.second);
-                if (it != textureReferences.end())
-                {
-                    materialInstance->setValue(pair.first, &it->second.preview);
-                }
+                tab->serialize(s);
+            }
+            else
+            {
+                s.j = data;
             }
-
-            materialTemplate.setSource(vertexCode, fragmentCode);
+        }
+        else
+        {
+            tab.reset();
+            data = s.j;
         }
     }
+
+private:
+    json data;
+    std::unique_ptr<MaterialTab> tab;
 };
 
-void serialize(Serializer& s, MaterialTab& tab)
+void serialize(Serializer& s, LazyMaterialTab& tab)
 {
     tab.serialize(s);
 }
\ No newline at end of file
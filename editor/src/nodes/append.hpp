@@ -53,7 +53,8 @@ struct AppendNode : ExpressionNode
         const auto resultType = Types::makeVec(totalArrity);
         outputs.at(0).type = resultType;
 
-        setOutput(0, Value{resultType, resultType.toString() + "(" + a.code + ", " + b.code + ")"});
+        const Value value{resultType, resultType.toString() + "(" + a.code + ", " + b.code + ")"};
+        setOutput(0, ConstantFolding::construct(resultType, std::array{a, b}).value_or(value));
     }
 
     static void registerArchetypes(ArchetypeRepo& repo)
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "archetype.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Ranked fuzzy search over archetypes. A query matches a field when its characters appear in it in order,
+// runs of consecutive characters and matches at word starts score higher. Archetypes used often get a boost.
+struct ArchetypeSearch
+{
+    struct Result
+    {
+        const NodeArchetype* archetype;
+        float score;
+    };
+
+    void add(const NodeArchetype& archetype)
+    {
+        Entry entry{&archetype};
+        entry.fields[0] = makeField(archetype.title, 3.f);
+        entry.fields[1] = makeField(archetype.id, 2.f);
+        entry.fields[2] = makeField(archetype.category, 1.f);
+        entry.usageBoost = usageBoost(usage[archetype.id]);
+
+        entries.push_back(std::move(entry));
+        cacheValid = false;
+    }
+
+    void recordUse(const NodeArchetype& archetype)
+    {
+        const auto boost = usageBoost(++usage[archetype.id]);
+        for (auto& entry : entries)
+        {
+            if (entry.archetype == &archetype)
+            {
+                entry.usageBoost = boost;
+            }
+        }
+
+        cacheValid = false;
+    }
+
+    // Best match first. Cached, asking again with the same query is free, and a query extending the
+    // previous one only rescans what the previous one matched.
+    std::span<const Result> find(std::string_view query)
+    {
+        std::string lowered{query};
+        std::ranges::transform(lowered, lowered.begin(), [](unsigned char c) { return std::tolower(c); });
+
+        if (cacheValid && lowered == lastQuery)
+        {
+            return results;
+        }
+
+        std::vector<std::size_t> candidates;
+        if (cacheValid && lowered.starts_with(lastQuery))
+        {
+            candidates = std::move(lastMatches);
+        }
+        else
+        {
+            candidates.resize(entries.size());
+            std::iota(candidates.begin(), candidates.end(), std::size_t{});
+        }
+
+        lastMatches.clear();
+        results.clear();
+
+        for (const auto index : candidates)
+        {
+            const auto& entry = entries[index];
+            if (const auto score = scoreEntry(entry, lowered))
+            {
+                lastMatches.push_back(index);
+                results.push_back({entry.archetype, *score + entry.usageBoost});
+            }
+        }
+
+        std::ranges::sort(results,
+                          [](const Result& a, const Result& b)
+                          {
+                              if (a.score != b.score)
+                              {
+                                  return a.score > b.score;
+                              }
+
+                              return a.archetype->title < b.archetype->title;
+                          });
+
+        lastQuery = std::move(lowered);
+        cacheValid = true;
+
+        return results;
+    }
+
+private:
+    struct Field
+    {
+        std::string text;
+        std::vector<bool> wordStarts;
+        float weight{};
+    };
+
+    struct Entry
+    {
+        const NodeArchetype* archetype;
+        std::array<Field, 3> fields;
+        float usageBoost{};
+    };
+
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, int> usage;
+
+    std::string lastQuery;
+    std::vector<std::size_t> lastMatches;
+    std::vector<Result> results;
+    bool cacheValid = false;
+
+    static float usageBoost(int uses)
+    {
+        return 4.f * std::log2(1.f + uses);
+    }
+
+    static Field makeField(std::string_view text, float weight)
+    {
+        Field field{std::string(text), std::vector<bool>(text.size()), weight};
+
+        for (std::size_t x = 0; x < text.size(); x++)
+        {
+            const unsigned char c = text[x];
+            const unsigned char previous = x > 0 ? text[x - 1] : ' ';
+
+            field.wordStarts[x] = !std::isalnum(previous) || (std::isupper(c) && std::islower(previous)) ||
+                                  (std::isdigit(c) && !std::isdigit(previous));
+            field.text[x] = static_cast<char>(std::tolower(c));
+        }
+
+        return field;
+    }
+
+    static std::optional<float> scoreEntry(const Entry& entry, std::string_view query)
+    {
+        std::optional<float> best;
+        for (const auto& field : entry.fields)
+        {
+            if (auto score = scoreField(field, query, true).or_else([&] { return scoreField(field, query, false); }))
+            {
+                best = std::max(best.value_or(0.f), *score * field.weight);
+            }
+        }
+
+        return best;
+    }
+
+    // Matches greedily left to right. With preferWordStarts a character jumps ahead to the next word start
+    // holding it, which can miss a match the plain pass finds.
+    static std::optional<float> scoreField(const Field& field, std::string_view query, bool preferWordStarts)
+    {
+        const std::string_view text = field.text;
+
+        float score = 0.f;
+        std::size_t position = 0;
+        std::size_t previousMatch = std::string_view::npos;
+
+        for (const char c : query)
+        {
+            std::size_t match = std::string_view::npos;
+
+            if (previousMatch != std::string_view::npos && previousMatch + 1 < text.size() && text[previousMatch + 1] == c)
+            {
+                match = previousMatch + 1;
+            }
+            else
+            {
+                if (preferWordStarts)
+                {
+                    for (auto x = text.find(c, position); x != std::string_view::npos; x = text.find(c, x + 1))
+                    {
+                        if (field.wordStarts[x])
+                        {
+                            match = x;
+                            break;
+                        }
+                    }
+                }
+
+                if (match == std::string_view::npos)
+                {
+                    match = text.find(c, position);
+                }
+            }
+
+            if (match == std::string_view::npos)
+            {
+                return std::nullopt;
+            }
+
+            score += 1.f;
+
+            if (previousMatch != std::string_view::npos && match == previousMatch + 1)
+            {
+                score += 4.f;
+            }
+
+            if (field.wordStarts[match])
+            {
+                score += match == 0 ? 8.f : 6.f;
+            }
+
+            // Skipping characters costs a little, up to a point
+            score -= std::min<float>(match - position, 3.f) * 0.5f;
+
+            previousMatch = match;
+            position = match + 1;
+        }
+
+        if (text == query)
+        {
+            score += 10.f;
+        }
+
+        // Shorter fields with the same match are closer to what was typed
+        return score - text.size() * 0.05f;
+    }
+};
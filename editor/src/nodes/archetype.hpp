@@ -38,7 +38,42 @@ struct NodeArchetype
 
     std::vector<Overload> overloads;
 
-    std::function<Graph::Node::Ptr()> createNode;
+    // Across the base pins and every overload: types the outputs can produce,
+    // and output types that at least one input would accept
+    TypeMasks::Mask producedTypes;
+    TypeMasks::Mask acceptedTypes;
+
+    void computeTypeMasks()
+    {
+        producedTypes.reset();
+        acceptedTypes.reset();
+
+        for (const auto& output : outputs)
+        {
+            producedTypes |= TypeMasks::of(output.type);
+        }
+
+        for (const auto& input : inputs)
+        {
+            acceptedTypes |= TypeMasks::sourcesOf(input.type);
+        }
+
+        for (const auto& overload : overloads)
+        {
+            for (const auto& type : overload.outputs)
+            {
+                producedTypes |= TypeMasks::of(type);
+            }
+
+            for (const auto& type : overload.inputs)
+            {
+                acceptedTypes |= TypeMasks::sourcesOf(type);
+            }
+        }
+    }
+
+    std::function<Graph::Node::Ptr(std::pmr::memory_resource&)> createNode;
+    std::function<Graph::Node::Ptr(const Graph::Node&, std::pmr::memory_resource&)> cloneNode;
 
     /*
 	static std::optional<std::pair<PinId, PinId>> findConnectTarget(const NodeArchetype& out, const NodeArchetype& in)
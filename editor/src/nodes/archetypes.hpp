@@ -1,5 +1,6 @@
 #pragma once
 
+#include "archetype-search.hpp"
 #include "archetype.hpp"
 #include "expression.hpp"
 #include "mls/serializer.hpp"
@@ -13,20 +14,33 @@ struct ArchetypeRepo
     ArchetypeRepo(const ArchetypeRepo&) = delete;
 
     std::unordered_map<std::string, NodeArchetype> archetypes;
+    ArchetypeSearch search;
 
-    const NodeArchetype& get(const std::string& id)
+    const NodeArchetype& get(const std::string& id) const
     {
-        return archetypes[id];
+        return archetypes.at(id);
     }
 
     template <typename T, typename... Args>
     const NodeArchetype& add(NodeArchetype archetype, Args... args)
     {
         auto& arch = archetypes.emplace(archetype.id, std::move(archetype)).first->second;
+        arch.computeTypeMasks();
+        search.add(arch);
         auto archetypeRawPtr = &arch;
-        arch.createNode = [=]()
+        arch.createNode = [=](std::pmr::memory_resource& resource) -> Graph::Node::Ptr
         {
-            return std::make_unique<T>(archetypeRawPtr, args...);
+            auto node = Graph::makeNode<T>(resource, archetypeRawPtr, args...);
+            if constexpr (requires { T::nodeKind; })
+            {
+                node->kind = T::nodeKind;
+            }
+
+            return node;
+        };
+        arch.cloneNode = [](const Graph::Node& node, std::pmr::memory_resource& resource) -> Graph::Node::Ptr
+        {
+            return Graph::makeNode<T>(resource, static_cast<const T&>(node));
         };
 
         return arch;
@@ -35,56 +49,58 @@ struct ArchetypeRepo
 
 struct NodeSerializer
 {
-    static inline ArchetypeRepo* repo{};
+    const ArchetypeRepo& repo;
+    // Where loaded nodes get allocated, the arena of the graph they are loaded into
+    std::pmr::memory_resource& resource;
 
-    static void serialize(Serializer& s, Graph::Node* n)
+    static void save(Serializer& s, Graph::Node* n)
     {
-        assert(repo);
-
-        if (s.isSaving)
-        {
-            if (!n)
-            {
-                return;
-            }
+        assert(s.isSaving);
 
-            auto& node = static_cast<ExpressionNode&>(*n);
-            s.serialize("type_id", node.archetype->id);
-            node.serialize(s);
-        }
-        else
+        if (!n)
         {
-            assert(false && "not supported");
+            return;
         }
+
+        auto& node = static_cast<ExpressionNode&>(*n);
+        s.serialize("type_id", node.archetype->id);
+        node.serialize(s);
     }
 
-    static void serialize(Serializer& s, Graph::Node::Ptr& n)
+    void serialize(Serializer& s, Graph::Node::Ptr& n) const
     {
-        assert(repo);
-
         if (s.isSaving)
         {
-            serialize(s, n.get());
+            save(s, n.get());
         }
         else
         {
             std::string typeId;
             s.serialize("type_id", typeId);
 
-            n = repo->get(typeId).createNode();
+            n = repo.get(typeId).createNode(resource);
 
             auto& node = static_cast<ExpressionNode&>(*n);
             node.serialize(s);
         }
     }
-};
 
-inline void serialize(Serializer& s, Graph::Node::Ptr& n)
-{
-    NodeSerializer::serialize(s, n);
-}
+    void serialize(Serializer& s, std::vector<Graph::Node::Ptr>& nodes) const
+    {
+        if (!s.isSaving)
+        {
+            nodes.resize(s.j.size());
+        }
+
+        for (std::size_t x = 0; x < nodes.size(); x++)
+        {
+            auto ss = s.at(x);
+            serialize(ss, nodes[x]);
+        }
+    }
+};
 
 inline void serialize(Serializer& s, Graph::Node* n)
 {
-    NodeSerializer::serialize(s, n);
-}
\ No newline at end of file
+    NodeSerializer::save(s, n);
+}
@@ -53,9 +53,11 @@ struct BinaryOpNode : ExpressionNode
         const auto& a = getInput(0);
         const auto& b = getInput(1);
 
-        const auto val = std::format("({} {} {})", a.code, operatorStrings[std::to_underlying(op)], b.code);
+        const auto* opString = operatorStrings[std::to_underlying(op)];
+        const auto& type = outputs.at(0).type;
+        const auto val = std::format("({} {} {})", a.code, opString, b.code);
 
-        setOutput(0, Value{outputs.at(0).type, val});
+        setOutput(0, ConstantFolding::binary(opString, type, a, b).value_or(Value{type, val}));
     }
 
     void serialize(Serializer& s) override
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "archetypes.hpp"
+#include "constant-folding.hpp"
 #include "expression.hpp"
 
 #include <array>
@@ -23,7 +24,8 @@ struct BreakVecNode : ExpressionNode
         {
             if (value)
             {
-                setOutput(x, {Types::scalar, value.code + "." + ("xyza"[x])});
+                const Value component{Types::scalar, value.code + "." + ("xyza"[x])};
+                setOutput(x, ConstantFolding::extract(value, x).value_or(component));
             }
             else
             {
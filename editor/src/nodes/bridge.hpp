@@ -4,6 +4,8 @@
 
 struct BridgeNode : ExpressionNode
 {
+    static constexpr NodeKind nodeKind = NodeKind::Bridge;
+
     using ExpressionNode::ExpressionNode;
 
     enum class ConnectionMode
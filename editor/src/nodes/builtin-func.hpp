@@ -15,11 +15,13 @@ struct BuiltinFuncNode : ExpressionNode
     void evaluate(CodeGenerator& generator) override
     {
         std::string code = func + "(";
+        std::vector<Value> args;
 
         const auto inputCount = inputs.size();
         for (uint8_t x = 0; x < inputCount; x++)
         {
-            code += getInput(x).code;
+            args.push_back(getInput(x));
+            code += args.back().code;
 
             if (x < inputCount - 1)
             {
@@ -29,7 +31,8 @@ struct BuiltinFuncNode : ExpressionNode
 
         code += ")";
 
-        setOutput(0, Value{outputs[0].type, code});
+        const Value value{outputs[0].type, code};
+        setOutput(0, ConstantFolding::builtin(func, value.type, args).value_or(value));
     }
 
     static void registerArchetypes(ArchetypeRepo& repo)
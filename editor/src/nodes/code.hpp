@@ -100,6 +100,7 @@ struct CodeNode : ExpressionNode
             setOutput(x, std::move(var));
         }
         
+        generator.useAllInputs();
         generator.callFunc(function, args);
     }
 
@@ -158,6 +159,7 @@ struct CodeNode : ExpressionNode
             if (ImGui::Button(ICON_FA_CIRCLE_MINUS))
             {
                 input.toRemove = true;
+                edited = true;
             }
             ImGui::PopStyleVar();
 
@@ -176,6 +178,7 @@ struct CodeNode : ExpressionNode
         if (ImGui::Button(ICON_FA_CIRCLE_PLUS))
         {
             inputs.emplace_back();
+            edited = true;
         }
         ImGui::PopStyleVar();
     }
@@ -205,6 +208,7 @@ struct CodeNode : ExpressionNode
             if (ImGui::Button(ICON_FA_CIRCLE_MINUS))
             {
                 output.toRemove = true;
+                edited = true;
             }
             ImGui::PopStyleVar();
 
@@ -229,6 +233,7 @@ struct CodeNode : ExpressionNode
         if (ImGui::Button(ICON_FA_CIRCLE_PLUS))
         {
             outputs.emplace_back();
+            edited = true;
         }
         ImGui::PopStyleVar();
         ImGui::SameLine();
@@ -313,6 +318,7 @@ struct CodeNode : ExpressionNode
         if (codeEditor.IsTextChanged())
         {
             function.body = codeEditor.GetTextLines();
+            edited = true;
         }
     }
 
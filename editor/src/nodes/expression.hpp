@@ -3,6 +3,7 @@
 #include "../constants.hpp"
 #include "archetype.hpp"
 #include "float-field.hpp"
+#include "small-vector.hpp"
 #include "value.hpp"
 
 struct CodeGenerator;
@@ -47,10 +48,29 @@ struct ExpressionNode : Graph::Node
         bool toRemove{};
     };
 
+    // An Input is over 350 bytes with its field, keeping even a few inline made every node kilobytes larger.
+    // Most nodes have a single output, that one stays inside the node allocation.
     std::vector<Input> inputs;
-    std::vector<Output> outputs;
+    SmallVector<Output, 1> outputs;
 
-    using Ptr = std::unique_ptr<ExpressionNode>;
+    // Set by draw for edits that don't go through an ImGui widget, e.g. the code editor
+    bool edited{};
+
+    // Where the last full draw put the pins, relative to the node
+    struct PinLayout
+    {
+        PinId pin;
+        ImVec2 boundsMin;
+        ImVec2 boundsMax;
+        ImVec2 pivotMin;
+        ImVec2 pivotMax;
+        ImVec2 direction;
+    };
+
+    // Footprint of the last full draw, recorded by the editor so drawProxy can stand in for draw.
+    // Empty until the node has been drawn once, and cleared whenever the node is updated.
+    ImVec2 drawnSize{};
+    std::vector<PinLayout> drawnPins;
 
     ExpressionNode(struct NodeArchetype* archetype) :
         archetype{archetype},
@@ -59,6 +79,12 @@ struct ExpressionNode : Graph::Node
     {
     }
 
+    // The archetype knows the concrete type, it registered the node
+    Graph::Node::Ptr clone(std::pmr::memory_resource& resource) const override
+    {
+        return archetype->cloneNode(*this, resource);
+    }
+
     Value getInput(uint8_t index) const
     {
         return inputs.at(index).value;
@@ -78,8 +104,12 @@ struct ExpressionNode : Graph::Node
     {
         s.serialize("id", id);
 
-        using namespace std::placeholders;
-        s.at("pos").serializeValue<ImVec2>(std::bind(ed::GetNodePosition, id), std::bind(ed::SetNodePosition, id, _1));
+        s.serialize("pos", position);
+
+        if (!s.isSaving)
+        {
+            positionDirty = true;
+        }
 
         std::vector<ValueField> fields;
 
@@ -103,27 +133,100 @@ struct ExpressionNode : Graph::Node
         }
     }
 
+    // Only called when the node, its links or the graph context changed, pin links are kept up to date by the editor
     virtual void update(GraphContext* inGraphContext)
     {
         graphContext = inGraphContext;
+    }
 
+    // Clears what the last code generation left on the node
+    void resetEvaluation()
+    {
         error = {};
 
-        for (std::size_t x{}; x < inputs.size(); x++)
+        for (auto& input : inputs)
         {
-            inputs[x].link = {};
-            inputs[x].value = {};
-            inputs[x].error = {};
+            input.value = {};
+            input.error = {};
         }
-        for (std::size_t x{}; x < outputs.size(); x++)
+
+        for (auto& output : outputs)
         {
-            outputs[x].linkCount = {};
-            outputs[x].value = {};
+            output.value = {};
         }
     }
 
     virtual void evaluate(CodeGenerator& generator) = 0;
 
+    bool hasDrawnLayout() const
+    {
+        return drawnSize.x > 0 && drawnSize.y > 0;
+    }
+
+    void invalidateLayout()
+    {
+        drawnSize = {};
+        drawnPins.clear();
+    }
+
+    // Cheap stand-in for draw, same size and pins as the last full draw but no widgets. The node and its pins stay
+    // live so links keep their ends, selection and dragging keep working. With summary it shows the header band and
+    // pin dots, for when the graph is zoomed out too far to read anything.
+    void drawProxy(bool summary)
+    {
+        ed::PushStyleVar(ed::StyleVar_NodePadding, ImVec4(0, 0, 0, 0));
+
+        ed::BeginNode(id);
+
+        const auto origin = ImGui::GetCursorScreenPos();
+        ImGui::Dummy(drawnSize);
+
+        auto* drawList = ImGui::GetWindowDrawList();
+
+        if (summary)
+        {
+            const auto alpha = static_cast<int>(255 * ImGui::GetStyle().Alpha);
+            const auto headerHeight = std::min(drawnSize.y, 24.f);
+            drawList->AddRectFilled(origin,
+                                    origin + ImVec2(drawnSize.x, headerHeight),
+                                    IM_COL32(255 / 3, 255 / 3, 0, alpha),
+                                    ed::GetStyle().NodeRounding,
+                                    ImDrawFlags_RoundCornersTop);
+        }
+
+        for (const auto& layout : drawnPins)
+        {
+            const auto isInput = layout.pin.direction() == PinDirection::In;
+
+            ed::PushStyleVar(isInput ? ed::StyleVar_TargetDirection : ed::StyleVar_SourceDirection, layout.direction);
+            ed::BeginPin(layout.pin, isInput ? ed::PinKind::Input : ed::PinKind::Output);
+            ed::PinRect(origin + layout.boundsMin, origin + layout.boundsMax);
+            ed::PinPivotRect(origin + layout.pivotMin, origin + layout.pivotMax);
+            ed::EndPin();
+            ed::PopStyleVar();
+
+            if (summary)
+            {
+                const auto color = [&]
+                {
+                    if (!isInput)
+                    {
+                        return outputs[layout.pin.index()].type.toColor();
+                    }
+
+                    const auto& input = inputs[layout.pin.index()];
+                    return input.type ? input.type.toColor() : input.value.type.toColor();
+                }();
+
+                drawList->AddCircleFilled(origin + (layout.pivotMin + layout.pivotMax) * 0.5f, 5.f, color);
+            }
+        }
+
+        ed::EndNode();
+
+        ed::PopStyleVar();
+    }
+
     virtual void draw()
     {
         ImGui::PushID(id.Get());
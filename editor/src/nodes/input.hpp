@@ -22,10 +22,12 @@ struct InputNode : ExpressionNode
     {
         if (isUniform)
         {
-            generator.shaderInputs[input] = type;
+            setOutput(0, generator.addInput(input, type));
+        }
+        else
+        {
+            setOutput(0, Value{type, input});
         }
-
-        setOutput(0, Value{type, input});
     }
 
     static void registerArchetypes(ArchetypeRepo& repo)
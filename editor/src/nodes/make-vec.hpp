@@ -1,6 +1,7 @@
 #pragma once
 
 #include "archetypes.hpp"
+#include "constant-folding.hpp"
 #include "expression.hpp"
 
 #include <array>
@@ -32,6 +33,7 @@ struct MakeVecNode : ExpressionNode
         }
 
         Value value;
+        std::vector<Value> parts;
 
         auto firstValue = getInput(0);
 
@@ -43,13 +45,14 @@ struct MakeVecNode : ExpressionNode
                 value.code += ", ";
             }
 
-            value.code += (x == 0 || firstOnlySet) ? firstValue.code : getInput(x).code;
+            parts.push_back((x == 0 || firstOnlySet) ? firstValue : getInput(x));
+            value.code += parts.back().code;
         }
 
         value.code += ")";
         value.type = Types::makeVec(arrity);
 
-        setOutput(0, value);
+        setOutput(0, ConstantFolding::construct(value.type, parts).value_or(value));
     }
 
     static void registerArchetypes(ArchetypeRepo& repo)
@@ -5,6 +5,8 @@
 
 struct OutputNode : ExpressionNode
 {
+    static constexpr NodeKind nodeKind = NodeKind::Output;
+
     using ExpressionNode::ExpressionNode;
 
     CodeGenerator::Type type;
@@ -27,9 +29,9 @@ struct OutputNode : ExpressionNode
 
             generator.shaderInputs["time"] = Types::scalar;
 
-            generator.body.insert(generator.body.begin(), "gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;");
-            generator.body.insert(generator.body.begin(), "gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;");
-            generator.body.push_back("gl_FrontColor = vec4(" + color.code + ");");
+            generator.body.insert(generator.body.begin(), {"gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;"});
+            generator.body.insert(generator.body.begin(), {"gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;"});
+            generator.addStatement("gl_FrontColor = vec4(" + color.code + ");");
         }
         else if (generator.type == CodeGenerator::Type::Fragment)
         {
@@ -43,11 +45,11 @@ struct OutputNode : ExpressionNode
 
             if (color)
             {
-                generator.body.push_back("gl_FragColor = vec4(" + color.code + ");");
+                generator.addStatement("gl_FragColor = vec4(" + color.code + ");");
             }
             else
             {
-                generator.body.push_back("gl_FragColor = gl_Color;");
+                generator.addStatement("gl_FragColor = gl_Color;");
             }
         }
     }
@@ -10,6 +10,8 @@
 
 struct ParameterNode : ExpressionNode
 {
+    static constexpr NodeKind nodeKind = NodeKind::Parameter;
+
     using ExpressionNode::ExpressionNode;
 
     std::string parameterId;
@@ -57,9 +59,7 @@ struct ParameterNode : ExpressionNode
 
                 const std::string parameterName = std::format("{}{}", Material::uniformPrefix, name);
 
-                setOutput(index, Value{type, parameterName});
-
-                generator.shaderInputs[parameterName] = type;
+                setOutput(index, generator.addInput(parameterName, type));
             };
 
             addOutput(0, it->second, parameterId);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ImGuiColorTextEdit/TextEditor.h"
+#include "code-generator.hpp"
+#include "nodes/archetypes.hpp"
+
+// Most node headers expect the ones above to come first
+#include "nodes/append.hpp"
+#include "nodes/binary-op.hpp"
+#include "nodes/break-vec.hpp"
+#include "nodes/bridge.hpp"
+#include "nodes/builtin-func.hpp"
+#include "nodes/code.hpp"
+#include "nodes/input.hpp"
+#include "nodes/make-vec.hpp"
+#include "nodes/noise.hpp"
+#include "nodes/output.hpp"
+#include "nodes/parameter.hpp"
+#include "nodes/random.hpp"
+#include "nodes/scalar-value.hpp"
+#include "nodes/texture-sample.hpp"
+#include "nodes/vec-value.hpp"
+
+// Every node the editor offers, shared by the editor and the benchmark
+inline void registerAllArchetypes(ArchetypeRepo& archetypes)
+{
+    VecValueNode::registerArchetypes(archetypes);
+    ScalarValueNode::registerArchetypes(archetypes);
+    MakeVecNode::registerArchetypes(archetypes);
+    BreakVecNode::registerArchetypes(archetypes);
+    InputNode::registerArchetypes(archetypes);
+    OutputNode::registerArchetypes(archetypes);
+    BinaryOpNode::registerArchetypes(archetypes);
+    BuiltinFuncNode::registerArchetypes(archetypes);
+    BridgeNode::registerArchetypes(archetypes);
+    AppendNode::registerArchetypes(archetypes);
+    ParameterNode::registerArchetypes(archetypes);
+    SampleTextureNode::registerArchetypes(archetypes);
+    RandomNode::registerArchetypes(archetypes);
+    CodeNode::registerArchetypes(archetypes);
+    NoiseNode::registerArchetypes(archetypes);
+}
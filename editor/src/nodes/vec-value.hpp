@@ -34,6 +34,12 @@ struct VecValueNode : ExpressionNode
         value.code += ")";
         value.type = Types::makeVec(arrity);
 
+        auto& constant = value.constant.emplace();
+        for (uint8_t x = 0; x < arrity; x++)
+        {
+            constant[x] = floatFields[x].value;
+        }
+
         setOutput(0, value);
     }
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ParallelUtils
+{
+
+// Calls func(index) for every index in [0, count) across a few worker threads.
+// The first exception thrown by any call is rethrown on the calling thread once all workers are done.
+template <typename F>
+void forEachIndex(std::size_t count, F&& func)
+{
+    const std::size_t workerCount = std::min<std::size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    if (workerCount <= 1)
+    {
+        for (std::size_t x = 0; x < count; x++)
+        {
+            func(x);
+        }
+
+        return;
+    }
+
+    std::atomic<std::size_t> nextIndex{};
+    std::exception_ptr exception;
+    std::mutex exceptionMutex;
+
+    const auto work = [&]
+    {
+        for (std::size_t index = nextIndex++; index < count; index = nextIndex++)
+        {
+            try
+            {
+                func(index);
+            }
+            catch (...)
+            {
+                std::lock_guard lock{exceptionMutex};
+                if (!exception)
+                {
+                    exception = std::current_exception();
+                }
+            }
+        }
+    };
+
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(workerCount - 1);
+        for (std::size_t x = 1; x < workerCount; x++)
+        {
+            workers.emplace_back(work);
+        }
+
+        work();
+    }
+
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+} // namespace ParallelUtils
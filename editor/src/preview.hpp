@@ -1,5 +1,7 @@
 #pragma once
 
+#include "profiler.hpp"
+
 #include <SFML/Graphics.hpp>
 
 #include <memory>
@@ -125,6 +127,8 @@ struct Preview
 
     void update(const sf::Shader& shader)
     {
+        PROFILE_SCOPE("Preview::update");
+
         ImGui::Checkbox("Fullscreen", &isFullScreenMode);
         ImGui::SameLine();
 
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "trace.hpp"
+
+// Frame profiler, only built with the MLSE_PROFILER option
+#ifdef MLSE_PROFILER
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Times named phases of each frame and keeps the last few seconds of them to show in an overlay.
+// A phase entered several times in a frame, e.g. once per tab, adds up. Scopes on other threads than the one
+// running the frame loop are left to the trace.
+struct Profiler
+{
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t historySize = 240;
+
+    struct Phase
+    {
+        std::string_view name;
+        float frameTime{};
+
+        // Milliseconds per frame, a ring buffer written at frameIndex
+        std::array<float, historySize> history{};
+    };
+
+    bool showOverlay = false;
+
+    static Profiler& get()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    void record(std::string_view name, Clock::duration duration)
+    {
+        if (std::this_thread::get_id() != frameThread)
+        {
+            return;
+        }
+
+        findPhase(name).frameTime += std::chrono::duration<float, std::milli>(duration).count();
+    }
+
+    // Called by the frame loop before the first phase of a frame, so the first frame is kept too
+    void beginFrame()
+    {
+        frameThread = std::this_thread::get_id();
+    }
+
+    // Called by the frame loop once every phase of the frame is closed
+    void endFrame()
+    {
+        for (auto& phase : phases)
+        {
+            phase.history[frameIndex] = phase.frameTime;
+            phase.frameTime = 0.f;
+        }
+
+        frameIndex = (frameIndex + 1) % historySize;
+        frames++;
+    }
+
+    void drawOverlay()
+    {
+        if (!showOverlay)
+        {
+            return;
+        }
+
+        ImGui::SetNextWindowSize({520.f, 0.f}, ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("Profiler", &showOverlay))
+        {
+            ImGui::End();
+            return;
+        }
+
+        const auto sampleCount = std::min(frames, historySize);
+
+        if (ImGui::BeginTable("phases", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+        {
+            ImGui::TableSetupColumn("Phase", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("Last");
+            ImGui::TableSetupColumn("p50");
+            ImGui::TableSetupColumn("p95");
+            ImGui::TableSetupColumn("p99");
+            ImGui::TableSetupColumn("Max");
+            ImGui::TableHeadersRow();
+
+            for (const auto& phase : phases)
+            {
+                std::vector<float> samples(sampleCount);
+                std::copy_n(phase.history.begin(), sampleCount, samples.begin());
+                std::ranges::sort(samples);
+
+                const auto percentile = [&](float p)
+                {
+                    return samples.empty() ? 0.f : samples[std::size_t(p * (samples.size() - 1))];
+                };
+
+                const auto last = phase.history[(frameIndex + historySize - 1) % historySize];
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(phase.name.data(), phase.name.data() + phase.name.size());
+
+                for (const auto value : {last, percentile(0.5f), percentile(0.95f), percentile(0.99f), percentile(1.f)})
+                {
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", value);
+                }
+            }
+
+            ImGui::EndTable();
+        }
+
+        ImGui::Separator();
+
+        // Oldest sample first, the histograms scroll to the left
+        const auto offset = sampleCount < historySize ? 0 : static_cast<int>(frameIndex);
+
+        for (const auto& phase : phases)
+        {
+            const auto max = *std::max_element(phase.history.begin(), phase.history.end());
+
+            char overlay[64];
+            std::snprintf(overlay, sizeof(overlay), "%.*s, max %.2f ms", int(phase.name.size()), phase.name.data(), max);
+
+            ImGui::PushID(phase.name.data(), phase.name.data() + phase.name.size());
+            ImGui::PlotHistogram("##history",
+                                 phase.history.data(),
+                                 static_cast<int>(sampleCount),
+                                 offset,
+                                 overlay,
+                                 0.f,
+                                 std::max(max, 1.f),
+                                 {-1.f, 40.f});
+            ImGui::PopID();
+        }
+
+        ImGui::End();
+    }
+
+private:
+    std::vector<Phase> phases;
+    std::size_t frameIndex{};
+    std::size_t frames{};
+    std::thread::id frameThread;
+
+    // A handful of phases, a linear search beats hashing the name
+    Phase& findPhase(std::string_view name)
+    {
+        const auto it = std::ranges::find(phases, name, &Phase::name);
+        if (it != phases.end())
+        {
+            return *it;
+        }
+
+        return phases.emplace_back(Phase{name});
+    }
+};
+
+#endif
+
+#if defined(MLSE_PROFILER) || defined(MLSE_TRACING)
+
+// Feeds the profiler and, while recording, the trace. Doesn't read the clock when neither wants it.
+struct ProfileScope
+{
+    using Clock = std::chrono::steady_clock;
+
+    const char* name;
+    bool timed;
+    Clock::time_point start;
+
+    explicit ProfileScope(const char* name) : name{name}, timed{isTimed()}
+    {
+        if (timed)
+        {
+            start = Clock::now();
+        }
+    }
+
+    ~ProfileScope()
+    {
+        if (!timed)
+        {
+            return;
+        }
+
+        const auto end = Clock::now();
+
+#ifdef MLSE_PROFILER
+        Profiler::get().record(name, end - start);
+#endif
+
+#ifdef MLSE_TRACING
+        if (TraceRecorder::get().isRecording())
+        {
+            TraceRecorder::get().add(name, start, end);
+        }
+#endif
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    static bool isTimed()
+    {
+#ifdef MLSE_PROFILER
+        return true;
+#else
+        return TraceRecorder::get().isRecording();
+#endif
+    }
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+// Times the rest of the enclosing block, name must outlive the program, e.g. a string literal
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__){name}
+
+#else
+
+#define PROFILE_SCOPE(name)
+
+#endif
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// Vector that keeps its first N elements inline, it only allocates once it grows past N.
+// Covers the subset of std::vector the editor uses.
+template <typename T, std::size_t N>
+class SmallVector
+{
+    static_assert(N > 0);
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+
+    template <std::input_iterator It>
+    SmallVector(It first, It last)
+    {
+        for (; first != last; ++first)
+        {
+            emplace_back(*first);
+        }
+    }
+
+    SmallVector(std::initializer_list<T> list) : SmallVector(list.begin(), list.end())
+    {
+    }
+
+    SmallVector(const SmallVector& other) : SmallVector(other.begin(), other.end())
+    {
+    }
+
+    SmallVector(SmallVector&& other) noexcept
+    {
+        takeFrom(other);
+    }
+
+    ~SmallVector()
+    {
+        clear();
+        releaseHeap();
+    }
+
+    SmallVector& operator=(const SmallVector& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            reserve(other.size());
+            for (const auto& value : other)
+            {
+                emplace_back(value);
+            }
+        }
+
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            releaseHeap();
+            takeFrom(other);
+        }
+
+        return *this;
+    }
+
+    iterator begin()
+    {
+        return elements;
+    }
+
+    const_iterator begin() const
+    {
+        return elements;
+    }
+
+    iterator end()
+    {
+        return elements + count;
+    }
+
+    const_iterator end() const
+    {
+        return elements + count;
+    }
+
+    T* data()
+    {
+        return elements;
+    }
+
+    const T* data() const
+    {
+        return elements;
+    }
+
+    size_type size() const
+    {
+        return count;
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    size_type capacity() const
+    {
+        return allocated;
+    }
+
+    T& operator[](size_type index)
+    {
+        assert(index < count);
+        return elements[index];
+    }
+
+    const T& operator[](size_type index) const
+    {
+        assert(index < count);
+        return elements[index];
+    }
+
+    T& at(size_type index)
+    {
+        if (index >= count)
+        {
+            throw std::out_of_range("SmallVector::at");
+        }
+
+        return elements[index];
+    }
+
+    const T& at(size_type index) const
+    {
+        if (index >= count)
+        {
+            throw std::out_of_range("SmallVector::at");
+        }
+
+        return elements[index];
+    }
+
+    T& front()
+    {
+        return (*this)[0];
+    }
+
+    T& back()
+    {
+        return (*this)[count - 1];
+    }
+
+    void reserve(size_type newCapacity)
+    {
+        if (newCapacity <= allocated)
+        {
+            return;
+        }
+
+        T* newElements = std::allocator<T>{}.allocate(newCapacity);
+        std::uninitialized_move(begin(), end(), newElements);
+        std::destroy(begin(), end());
+        releaseHeap();
+
+        elements = newElements;
+        allocated = newCapacity;
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (count == allocated)
+        {
+            // Args may refer to one of our own elements, build the value before moving them
+            T value(std::forward<Args>(args)...);
+            reserve(allocated * 2);
+            return *std::construct_at(elements + count++, std::move(value));
+        }
+
+        return *std::construct_at(elements + count++, std::forward<Args>(args)...);
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    void pop_back()
+    {
+        assert(count > 0);
+        std::destroy_at(elements + --count);
+    }
+
+    void resize(size_type newSize)
+    {
+        if (newSize < count)
+        {
+            std::destroy(begin() + newSize, end());
+            count = newSize;
+            return;
+        }
+
+        reserve(newSize);
+        for (; count < newSize; count++)
+        {
+            std::construct_at(elements + count);
+        }
+    }
+
+    iterator erase(const_iterator position)
+    {
+        const auto index = static_cast<size_type>(position - begin());
+        assert(index < count);
+
+        std::move(begin() + index + 1, end(), begin() + index);
+        pop_back();
+
+        return begin() + index;
+    }
+
+    void clear()
+    {
+        std::destroy(begin(), end());
+        count = 0;
+    }
+
+private:
+    alignas(T) std::byte inlineStorage[N * sizeof(T)];
+    T* elements = reinterpret_cast<T*>(inlineStorage);
+    size_type count = 0;
+    size_type allocated = N;
+
+    bool isInline() const
+    {
+        return elements == reinterpret_cast<const T*>(inlineStorage);
+    }
+
+    void releaseHeap()
+    {
+        if (!isInline())
+        {
+            std::allocator<T>{}.deallocate(elements, allocated);
+            elements = reinterpret_cast<T*>(inlineStorage);
+            allocated = N;
+        }
+    }
+
+    void takeFrom(SmallVector& other)
+    {
+        if (other.isInline())
+        {
+            std::uninitialized_move(other.begin(), other.end(), elements);
+            count = other.count;
+            other.clear();
+            return;
+        }
+
+        elements = other.elements;
+        count = other.count;
+        allocated = other.allocated;
+
+        other.elements = reinterpret_cast<T*>(other.inlineStorage);
+        other.count = 0;
+        other.allocated = N;
+    }
+};
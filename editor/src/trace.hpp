@@ -0,0 +1,122 @@
+#pragma once
+
+// Session trace recording, built unless MLSE_TRACING is turned off. Events come from PROFILE_SCOPE.
+#ifdef MLSE_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Records timed scopes from any thread while enabled, and writes them as Chrome trace-event JSON, which
+// chrome://tracing and Perfetto open. Only the most recent events are kept, so it is safe to leave running.
+struct TraceRecorder
+{
+    using Clock = std::chrono::steady_clock;
+
+    // About 8 MB of events
+    static constexpr std::size_t capacity = 256 * 1024;
+
+    struct Event
+    {
+        const char* name;
+        Clock::time_point start;
+        Clock::time_point end;
+        std::uint32_t thread;
+    };
+
+    static TraceRecorder& get()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    // Small sequential ids read better in a trace viewer than hashed std::thread::id
+    static std::uint32_t currentThread()
+    {
+        static std::atomic<std::uint32_t> nextThread{1};
+        thread_local const std::uint32_t thread = nextThread++;
+        return thread;
+    }
+
+    bool isRecording() const
+    {
+        return recording.load(std::memory_order_relaxed);
+    }
+
+    // Starting again drops the events of the previous session
+    void setRecording(bool enable)
+    {
+        std::lock_guard lock{mutex};
+
+        if (enable && !isRecording())
+        {
+            events.clear();
+            nextEvent = 0;
+            sessionStart = Clock::now();
+        }
+
+        recording.store(enable, std::memory_order_relaxed);
+    }
+
+    std::size_t eventCount() const
+    {
+        std::lock_guard lock{mutex};
+        return events.size();
+    }
+
+    void add(const char* name, Clock::time_point start, Clock::time_point end)
+    {
+        const Event event{name, start, end, currentThread()};
+
+        std::lock_guard lock{mutex};
+
+        if (events.size() < capacity)
+        {
+            events.push_back(event);
+        }
+        else
+        {
+            events[nextEvent] = event;
+            nextEvent = (nextEvent + 1) % capacity;
+        }
+    }
+
+    std::string toJson() const
+    {
+        std::lock_guard lock{mutex};
+
+        std::string json = R"({"displayTimeUnit":"ms","traceEvents":[)";
+        json += R"({"name":"process_name","ph":"M","pid":1,"tid":0,"args":{"name":"MLSE"}})";
+
+        const auto micros = [&](Clock::time_point time)
+        { return std::chrono::duration<double, std::micro>(time - sessionStart).count(); };
+
+        // Oldest first once the buffer has wrapped
+        for (std::size_t x = 0; x < events.size(); x++)
+        {
+            const auto& event = events[(nextEvent + x) % events.size()];
+            json += std::format(R"(,{{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                                event.name,
+                                event.thread,
+                                micros(event.start),
+                                micros(event.end) - micros(event.start));
+        }
+
+        json += "]}";
+        return json;
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::atomic<bool> recording{false};
+
+    std::vector<Event> events;
+    std::size_t nextEvent{};
+    Clock::time_point sessionStart;
+};
+
+#endif
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "graph.hpp"
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Undo/redo log of graph deltas. A step only holds what it touched: the serialized state of the nodes it
+// added, removed or edited, the links it added or removed and the positions of the nodes it moved.
+struct UndoHistory
+{
+    struct NodeDelta
+    {
+        NodeId node{0};
+
+        // Serialized node before and after the step, empty when the node didn't exist
+        std::string before;
+        std::string after;
+
+        // Archetype ids of both states. An id freed and reused within a step holds a node of another type after.
+        std::string beforeArchetype;
+        std::string afterArchetype;
+
+        bool isEdit() const
+        {
+            return !before.empty() && !after.empty() && beforeArchetype == afterArchetype;
+        }
+    };
+
+    struct NodeMove
+    {
+        NodeId node{0};
+        ImVec2 before;
+        ImVec2 after;
+    };
+
+    struct Step
+    {
+        std::vector<NodeDelta> nodes;
+        std::vector<NodeMove> moves;
+        std::vector<LinkId> linksAdded;
+        std::vector<LinkId> linksRemoved;
+
+        bool empty() const
+        {
+            return nodes.empty() && moves.empty() && linksAdded.empty() && linksRemoved.empty();
+        }
+
+        std::size_t byteSize() const
+        {
+            std::size_t size = sizeof(Step) + moves.size() * sizeof(NodeMove) +
+                               (linksAdded.size() + linksRemoved.size()) * sizeof(LinkId);
+
+            for (const auto& delta : nodes)
+            {
+                size += sizeof(NodeDelta) + delta.before.size() + delta.after.size() + delta.beforeArchetype.size() +
+                        delta.afterArchetype.size();
+            }
+
+            return size;
+        }
+
+        // Only edits the fields of a single node, consecutive steps like that can be merged
+        bool isSingleNodeEdit() const
+        {
+            return nodes.size() == 1 && nodes[0].isEdit() && moves.empty() && linksAdded.empty() && linksRemoved.empty();
+        }
+    };
+
+    // Oldest steps are dropped once undo and redo steps together grow past this
+    std::size_t memoryBudget = 64 * 1024 * 1024;
+
+    // Edits of the same node closer together than this become one step, e.g. typing in a code node
+    std::chrono::milliseconds coalesceWindow{750};
+
+    void push(Step&& step)
+    {
+        clearRedo();
+
+        const auto now = std::chrono::steady_clock::now();
+
+        if (canCoalesce(step, now))
+        {
+            auto& last = undoSteps.back().nodes[0];
+            usedBytes -= last.after.size();
+            last.after = std::move(step.nodes[0].after);
+            usedBytes += last.after.size();
+        }
+        else
+        {
+            usedBytes += step.byteSize();
+            undoSteps.push_back(std::move(step));
+        }
+
+        lastPushTime = now;
+        coalesceBarrier = false;
+
+        trim();
+    }
+
+    // Moves the latest step to the redo list and returns it, the caller reverts it
+    const Step* undo()
+    {
+        if (undoSteps.empty())
+        {
+            return nullptr;
+        }
+
+        redoSteps.push_back(std::move(undoSteps.back()));
+        undoSteps.pop_back();
+        coalesceBarrier = true;
+
+        return &redoSteps.back();
+    }
+
+    // Moves the latest undone step back to the undo list and returns it, the caller applies it again
+    const Step* redo()
+    {
+        if (redoSteps.empty())
+        {
+            return nullptr;
+        }
+
+        undoSteps.push_back(std::move(redoSteps.back()));
+        redoSteps.pop_back();
+        coalesceBarrier = true;
+
+        return &undoSteps.back();
+    }
+
+    bool canUndo() const
+    {
+        return !undoSteps.empty();
+    }
+
+    bool canRedo() const
+    {
+        return !redoSteps.empty();
+    }
+
+    void clear()
+    {
+        undoSteps.clear();
+        redoSteps.clear();
+        usedBytes = 0;
+        coalesceBarrier = true;
+    }
+
+    std::size_t memoryUsed() const
+    {
+        return usedBytes;
+    }
+
+private:
+    std::deque<Step> undoSteps;
+    std::vector<Step> redoSteps;
+    std::size_t usedBytes{};
+
+    std::chrono::steady_clock::time_point lastPushTime;
+    bool coalesceBarrier = true;
+
+    bool canCoalesce(const Step& step, std::chrono::steady_clock::time_point now) const
+    {
+        if (coalesceBarrier || undoSteps.empty() || now - lastPushTime > coalesceWindow)
+        {
+            return false;
+        }
+
+        const auto& last = undoSteps.back();
+        return step.isSingleNodeEdit() && last.isSingleNodeEdit() && last.nodes[0].node == step.nodes[0].node;
+    }
+
+    void clearRedo()
+    {
+        for (const auto& step : redoSteps)
+        {
+            usedBytes -= step.byteSize();
+        }
+
+        redoSteps.clear();
+    }
+
+    // The latest step is kept even when it alone is over budget
+    void trim()
+    {
+        while (usedBytes > memoryBudget && undoSteps.size() > 1)
+        {
+            usedBytes -= undoSteps.front().byteSize();
+            undoSteps.pop_front();
+        }
+    }
+};
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
+#include <bitset>
 #include <format>
+#include <optional>
 #include <string>
 #include <variant>
 
@@ -98,6 +101,8 @@ struct ValueType : std::variant<NoneType, GenType, MatrixType, SamplerType, Arra
         assert(false);
     }
 
+    // Headless builds, like MLSE_bench, have no ImGui
+#ifndef MLSE_HEADLESS_GRAPH
     ImColor toColor() const
     {
         if (const auto* t = std::get_if<NoneType>(this))
@@ -122,6 +127,7 @@ struct ValueType : std::variant<NoneType, GenType, MatrixType, SamplerType, Arra
 
         assert(false);
     }
+#endif
 
     bool isScalar() const
     {
@@ -194,11 +200,66 @@ bool canConvert(ValueType from, ValueType to)
     return false;
 }
 
+// Whether an output of type outType may be linked to an input of type inType, none stands for "any GenType"
+bool canConnect(ValueType outType, ValueType inType)
+{
+    if (canConvert(outType, inType))
+    {
+        return true;
+    }
+
+    if (!outType && inType.isGenType())
+    {
+        return true;
+    }
+
+    if (outType.isGenType() && !inType)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+// One bit per type a pin can have, so "can any of these connect to any of those" is a single AND
+namespace TypeMasks
+{
+static inline constexpr std::array<ValueType, 6> types{Types::none, Types::scalar, Types::vec2, Types::vec3, Types::vec4, Types::texture};
+
+using Mask = std::bitset<types.size()>;
+
+Mask of(const ValueType& type)
+{
+    Mask mask;
+    for (std::size_t x = 0; x < types.size(); x++)
+    {
+        mask[x] = types[x] == type;
+    }
+
+    return mask;
+}
+
+// Every output type that could be linked to an input of the given type
+Mask sourcesOf(const ValueType& inType)
+{
+    Mask mask;
+    for (std::size_t x = 0; x < types.size(); x++)
+    {
+        mask[x] = canConnect(types[x], inType);
+    }
+
+    return mask;
+}
+} // namespace TypeMasks
+
 struct Value
 {
     ValueType type;
     std::string code;
 
+    // Components known while generating, for constant folding. Empty when the value depends on the shader's inputs.
+    std::optional<std::array<float, 4>> constant;
+
     operator bool() const
     {
         return type;
@@ -238,7 +299,14 @@ Value convert(const Value& value, const ValueType& type)
             }
             code += value.code;
             code += ")";
-            return {type, code};
+
+            std::optional<std::array<float, 4>> constant;
+            if (value.constant)
+            {
+                constant.emplace().fill((*value.constant)[0]);
+            }
+
+            return {type, code, constant};
         }
     }
 
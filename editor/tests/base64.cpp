@@ -0,0 +1,231 @@
+#include "mls/base64.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+using base64::detail::Isa;
+
+// Every kernel the CPU runs, scalar first
+std::vector<Isa> supportedIsas()
+{
+    std::vector<Isa> isas{Isa::Scalar};
+    for (const auto isa : {Isa::Sse41, Isa::Avx2})
+    {
+        if (isa <= base64::detail::detect_isa())
+        {
+            isas.push_back(isa);
+        }
+    }
+    return isas;
+}
+
+// Puts the best kernel back once a case is done with them
+struct IsaGuard
+{
+    ~IsaGuard()
+    {
+        base64::set_max_isa(base64::detail::detect_isa());
+    }
+};
+
+// Written from the RFC 4648 definition rather than the codec's tables
+std::string referenceEncode(std::string_view bytes)
+{
+    static constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string encoded;
+    for (std::size_t x = 0; x < bytes.size(); x += 3)
+    {
+        const std::size_t count = std::min<std::size_t>(3, bytes.size() - x);
+
+        std::uint32_t group = 0;
+        for (std::size_t y = 0; y < 3; y++)
+        {
+            group = group << 8 | (y < count ? static_cast<std::uint8_t>(bytes[x + y]) : 0);
+        }
+
+        for (std::size_t y = 0; y < 4; y++)
+        {
+            encoded += y <= count ? alphabet[group >> (18 - 6 * y) & 63] : '=';
+        }
+    }
+    return encoded;
+}
+
+std::string randomBytes(std::size_t size, std::mt19937& random)
+{
+    std::string bytes(size, '\0');
+    for (auto& byte : bytes)
+    {
+        byte = static_cast<char>(random());
+    }
+    return bytes;
+}
+
+struct Decoded
+{
+    bool threw{};
+    std::string bytes;
+
+    bool operator==(const Decoded&) const = default;
+};
+
+Decoded decodeWith(Isa isa, std::string_view text)
+{
+    base64::set_max_isa(isa);
+
+    try
+    {
+        return {false, base64::from_base64(text)};
+    }
+    catch (const std::runtime_error&)
+    {
+        return {true, {}};
+    }
+}
+
+// Longer than two AVX2 blocks on both sides, so every kernel runs full blocks and leaves a tail
+constexpr std::size_t MaxLength = 300;
+
+bool isAlphabet(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '+' || c == '/';
+}
+
+} // namespace
+
+TEST_CASE("base64/encode_matches_reference_for_every_length")
+{
+    const IsaGuard guard;
+    std::mt19937 random{1};
+
+    for (std::size_t length = 0; length <= MaxLength; length++)
+    {
+        // Every byte value, at every offset of a block
+        std::string ramp(length, '\0');
+        for (std::size_t x = 0; x < length; x++)
+        {
+            ramp[x] = static_cast<char>(x * 7 + length);
+        }
+
+        for (const auto& bytes : {randomBytes(length, random), ramp})
+        {
+            const auto expected = referenceEncode(bytes);
+
+            for (const auto isa : supportedIsas())
+            {
+                base64::set_max_isa(isa);
+                CHECK(base64::to_base64(bytes) == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("base64/decode_round_trips_every_length")
+{
+    const IsaGuard guard;
+    std::mt19937 random{2};
+
+    for (std::size_t length = 0; length <= MaxLength; length++)
+    {
+        const auto bytes = randomBytes(length, random);
+        const auto encoded = referenceEncode(bytes);
+
+        for (const auto isa : supportedIsas())
+        {
+            CHECK(decodeWith(isa, encoded) == Decoded{false, bytes});
+        }
+    }
+}
+
+TEST_CASE("base64/decode_rejects_invalid_characters_at_every_position")
+{
+    const IsaGuard guard;
+    std::mt19937 random{3};
+
+    // Each side of every alphabet range, control and high bytes, and padding where it can't be
+    static constexpr std::string_view boundaries{"\x00\x7f\x80\xff*,-.:;@[`{=", 15};
+
+    std::string everyInvalid;
+    for (int c = 0; c < 256; c++)
+    {
+        if (!isAlphabet(static_cast<char>(c)))
+        {
+            everyInvalid += static_cast<char>(c);
+        }
+    }
+
+    // Every length up to past an AVX2 and an SSE block, then a few spanning several blocks
+    for (std::size_t length = 1; length <= 100; length += length < 40 ? 1 : 7)
+    {
+        const auto encoded = referenceEncode(randomBytes(length, random));
+
+        // Every invalid byte on one length with full blocks and a tail, the boundaries elsewhere
+        const std::string_view invalid = length == 68 ? std::string_view{everyInvalid} : boundaries;
+
+        for (std::size_t position = 0; position < encoded.size(); position++)
+        {
+            for (const char c : invalid)
+            {
+                auto corrupted = encoded;
+                corrupted[position] = c;
+
+                const auto expected = decodeWith(Isa::Scalar, corrupted);
+
+                // Only a padding sign in the last quad can still decode, and never to other bytes
+                if (c != '=' || position + 4 < encoded.size())
+                {
+                    CHECK(expected.threw);
+                }
+
+                for (const auto isa : supportedIsas())
+                {
+                    CHECK(decodeWith(isa, corrupted) == expected);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("base64/decode_rejects_bad_sizes_and_padding")
+{
+    const IsaGuard guard;
+    std::mt19937 random{4};
+
+    const auto encoded = referenceEncode(randomBytes(120, random));
+
+    std::vector<std::string> invalid;
+    for (std::size_t cut = 1; cut <= 3; cut++)
+    {
+        invalid.push_back(encoded.substr(0, encoded.size() - cut));
+        invalid.push_back(encoded + std::string(cut, 'A'));
+    }
+
+    for (const auto* tail : {"A===", "====", "AB=C", "A=BC", "=ABC"})
+    {
+        invalid.push_back(encoded + tail);
+        invalid.push_back(tail);
+    }
+
+    for (const auto& text : invalid)
+    {
+        for (const auto isa : supportedIsas())
+        {
+            CHECK(decodeWith(isa, text).threw);
+        }
+    }
+
+    for (const auto isa : supportedIsas())
+    {
+        CHECK(decodeWith(isa, "") == Decoded{});
+    }
+}
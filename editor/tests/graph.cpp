@@ -0,0 +1,226 @@
+#include "graph.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+struct TestNode : Graph::Node
+{
+    Ptr clone(std::pmr::memory_resource& resource) const override
+    {
+        return Graph::makeNode<TestNode>(resource, *this);
+    }
+};
+
+std::vector<NodeId> addNodes(Graph& graph, std::size_t count)
+{
+    std::vector<NodeId> ids;
+    for (std::size_t x = 0; x < count; x++)
+    {
+        ids.push_back(graph.AddNode(Graph::makeNode<TestNode>(graph.nodeArena)).id);
+    }
+    return ids;
+}
+
+bool link(Graph& graph, NodeId from, NodeId to, PinId::PinIndex input = 0)
+{
+    return graph.addLink(PinId::makeOutput(from, 0), PinId::makeInput(to, input));
+}
+
+// Every producer ordered before its consumers
+bool isTopological(const Graph& graph)
+{
+    return std::ranges::all_of(graph.links,
+                               [&](LinkId link)
+                               { return graph.orderOf(link.from().nodeId()) < graph.orderOf(link.to().nodeId()); });
+}
+
+// No link in the index that isn't in the graph, and every link of the graph indexed on both of its nodes and pins
+bool isIndexed(const Graph& graph)
+{
+    std::size_t indexed = 0;
+    for (const auto& node : graph.nodes)
+    {
+        for (const auto link : graph.getLinks(node->id))
+        {
+            indexed++;
+            if (!graph.hasLink(link))
+            {
+                return false;
+            }
+        }
+    }
+
+    return indexed == 2 * graph.links.size() &&
+           std::ranges::all_of(graph.links,
+                               [&](LinkId link)
+                               {
+                                   return std::ranges::count(graph.getLinks(link.from()), link) == 1 &&
+                                          std::ranges::count(graph.getLinks(link.to()), link) == 1;
+                               });
+}
+
+// Deep enough that anything recursing once per node would run out of stack
+constexpr std::size_t ChainLength = 100'000;
+
+} // namespace
+
+TEST_CASE("graph/links_a_long_chain_in_topological_order")
+{
+    Graph graph;
+    const auto chain = addNodes(graph, ChainLength);
+
+    for (std::size_t x = 1; x < chain.size(); x++)
+    {
+        CHECK(link(graph, chain[x - 1], chain[x]));
+    }
+
+    CHECK(graph.links.size() == ChainLength - 1);
+    CHECK(isTopological(graph));
+}
+
+TEST_CASE("graph/reorders_when_linking_against_creation_order")
+{
+    // Each node feeds the one created before it, so every link moves the producer ahead of everything downstream.
+    // That visits the whole chain each time, hence a short one.
+    static constexpr std::size_t length = 2000;
+
+    Graph graph;
+    const auto chain = addNodes(graph, length);
+
+    for (std::size_t x = 1; x < chain.size(); x++)
+    {
+        CHECK(link(graph, chain[x], chain[x - 1]));
+    }
+
+    CHECK(graph.links.size() == length - 1);
+    CHECK(isTopological(graph));
+
+    // Merging into a second chain half way along keeps it valid too
+    const auto side = addNodes(graph, 1000);
+    for (std::size_t x = 1; x < side.size(); x++)
+    {
+        CHECK(link(graph, side[x - 1], side[x]));
+    }
+    CHECK(link(graph, chain[length / 2], side.front()));
+    CHECK(link(graph, side.back(), chain.front(), 1));
+    CHECK(isTopological(graph));
+}
+
+TEST_CASE("graph/refuses_links_closing_a_cycle")
+{
+    Graph graph;
+    const auto chain = addNodes(graph, ChainLength);
+    for (std::size_t x = 1; x < chain.size(); x++)
+    {
+        link(graph, chain[x - 1], chain[x]);
+    }
+
+    const auto links = graph.links;
+    const auto revision = graph.revision();
+
+    CHECK(!link(graph, chain.front(), chain.front(), 1));
+    for (std::size_t x = 0; x < chain.size(); x += chain.size() / 100)
+    {
+        CHECK(!link(graph, chain.back(), chain[x], 1));
+    }
+
+    // Refused links change nothing, not even the link they would have replaced
+    CHECK(graph.links == links);
+    CHECK(graph.revision() == revision);
+    CHECK(isIndexed(graph));
+
+    // Skipping ahead along the chain is fine
+    CHECK(link(graph, chain.front(), chain.back(), 1));
+    CHECK(isTopological(graph));
+}
+
+TEST_CASE("graph/removing_a_node_removes_its_links")
+{
+    Graph graph;
+    const auto chain = addNodes(graph, 1000);
+    for (std::size_t x = 1; x < chain.size(); x++)
+    {
+        link(graph, chain[x - 1], chain[x]);
+    }
+
+    const auto removed = chain[500];
+    graph.removeNode(removed);
+
+    CHECK(!graph.findNode<Graph::Node>(removed));
+    CHECK(graph.nodes.size() == chain.size() - 1);
+    CHECK(graph.links.size() == chain.size() - 3);
+    CHECK(graph.getLinks(removed).empty());
+    CHECK(isIndexed(graph));
+
+    // The freed id comes back to a node without links, which can then bridge the gap again
+    const auto replacement = addNodes(graph, 1).front();
+    CHECK(replacement == removed);
+    CHECK(graph.getLinks(replacement).empty());
+
+    CHECK(link(graph, chain[499], replacement));
+    CHECK(link(graph, replacement, chain[501]));
+    CHECK(!link(graph, chain[999], replacement, 1));
+    CHECK(isTopological(graph));
+    CHECK(isIndexed(graph));
+}
+
+TEST_CASE("graph/collects_upstream_producers_first")
+{
+    Graph graph;
+    const auto chain = addNodes(graph, ChainLength);
+    for (std::size_t x = 1; x < chain.size(); x++)
+    {
+        link(graph, chain[x - 1], chain[x]);
+    }
+
+    // Downstream nodes and unrelated ones aren't collected
+    const auto unrelated = addNodes(graph, 2);
+    link(graph, chain.back(), unrelated[0]);
+
+    const auto root = chain.back();
+    const auto upstream = graph.collectUpstream(root, [](NodeId) { return false; });
+    CHECK(upstream == chain);
+
+    // Skipping a node cuts off everything that only reaches the root through it
+    const auto cut = graph.collectUpstream(root, [&](NodeId id) { return id == chain[ChainLength - 11]; });
+    CHECK(cut.size() == 10);
+    CHECK(std::ranges::equal(cut, std::span{chain}.last(10)));
+}
+
+TEST_CASE("graph/journal_keeps_retained_changes")
+{
+    Graph graph;
+    const auto nodes = addNodes(graph, 2);
+
+    const auto edit = [&](std::size_t count)
+    {
+        for (std::size_t x = 0; x < count; x++)
+        {
+            graph.recordChange(GraphChange::Type::NodeEdited, nodes[x % 2]);
+        }
+    };
+
+    // Trimmed as it grows when nobody retains it
+    auto since = graph.revision();
+    edit(10'000);
+    CHECK(!graph.changesSince(since));
+
+    // A retained revision survives any number of changes, until the retention moves on
+    since = graph.revision();
+    graph.retainJournal(since);
+    edit(10'000);
+
+    const auto changes = graph.changesSince(since);
+    CHECK(changes && changes->size() == 10'000);
+    CHECK(changes && changes->front().revision == since + 1);
+
+    graph.retainJournal(graph.revision());
+    edit(10'000);
+    CHECK(!graph.changesSince(since));
+}
@@ -0,0 +1,66 @@
+#include "id-pool.hpp"
+#include "test.hpp"
+
+#include <cstdint>
+
+namespace
+{
+
+using Pool = IdPool<std::uint32_t>;
+
+} // namespace
+
+TEST_CASE("id_pool/reuses_released_ids_oldest_first")
+{
+    Pool pool;
+    for (std::uint32_t id = 1; id <= 4; id++)
+    {
+        CHECK(pool.take() == id);
+    }
+
+    pool.release(3);
+    pool.release(1);
+
+    CHECK(pool.take() == 3);
+    CHECK(pool.take() == 1);
+    CHECK(pool.take() == 5);
+    CHECK(pool.capacity() == 6);
+}
+
+TEST_CASE("id_pool/claims_only_free_ids")
+{
+    Pool pool;
+    pool.reset(3);
+
+    // Taken ids and 0 are refused and change nothing
+    CHECK(!pool.claim(0));
+    CHECK(!pool.claim(2));
+    CHECK(pool.take() == 4);
+
+    pool.release(2);
+    CHECK(pool.claim(2));
+    CHECK(!pool.claim(2));
+
+    // Past the end, the ids skipped on the way become free
+    CHECK(pool.claim(7));
+    CHECK(!pool.claim(7));
+    CHECK(pool.capacity() == 8);
+    CHECK(pool.take() == 5);
+    CHECK(pool.claim(6));
+    CHECK(pool.take() == 8);
+}
+
+TEST_CASE("id_pool/handles_go_stale_on_release")
+{
+    Pool pool;
+    const auto id = pool.take();
+    const auto handle = pool.makeHandle(id);
+    CHECK(pool.isCurrent(handle));
+
+    pool.release(id);
+    CHECK(!pool.isCurrent(handle));
+
+    CHECK(pool.claim(id));
+    CHECK(!pool.isCurrent(handle));
+    CHECK(pool.isCurrent(pool.makeHandle(id)));
+}
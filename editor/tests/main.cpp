@@ -0,0 +1,43 @@
+// Checks of the editor's containers and codecs. Runs every case, or the ones whose name contains the argument.
+
+#include "test.hpp"
+
+#include <exception>
+#include <string_view>
+
+int main(int argc, char** argv)
+{
+    const std::string_view filter = argc > 1 ? argv[1] : "";
+
+    int failedCases = 0;
+    int ranCases = 0;
+
+    for (const auto& testCase : Test::cases())
+    {
+        if (!testCase.name.contains(filter))
+        {
+            continue;
+        }
+
+        const auto failedBefore = Test::failedChecks;
+
+        try
+        {
+            testCase.run();
+        } catch (const std::exception& e)
+        {
+            std::fprintf(stderr, "%.*s: unexpected exception: %s\n", int(testCase.name.size()), testCase.name.data(), e.what());
+            Test::failedChecks++;
+        }
+
+        const bool failed = Test::failedChecks != failedBefore;
+        failedCases += failed;
+        ranCases++;
+
+        std::printf("%s %.*s\n", failed ? "FAIL" : "ok  ", int(testCase.name.size()), testCase.name.data());
+    }
+
+    std::printf("%d of %d cases passed\n", ranCases - failedCases, ranCases);
+
+    return failedCases == 0 && ranCases > 0 ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+#include "small-vector.hpp"
+#include "test.hpp"
+
+#include <string>
+
+namespace
+{
+
+// Counts live instances, so a leaked or doubly destroyed element shows up
+struct Tracked
+{
+    static inline int alive = 0;
+
+    std::string value;
+
+    Tracked(std::string value = {}) : value{std::move(value)}
+    {
+        alive++;
+    }
+
+    Tracked(const Tracked& other) : value{other.value}
+    {
+        alive++;
+    }
+
+    Tracked(Tracked&& other) noexcept : value{std::move(other.value)}
+    {
+        alive++;
+    }
+
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) noexcept = default;
+
+    ~Tracked()
+    {
+        alive--;
+    }
+};
+
+using Vector = SmallVector<Tracked, 3>;
+
+// Long enough to never fit std::string's own inline buffer, so a bad move shows up as garbage
+std::string item(int index)
+{
+    return "an item long enough to live on the heap #" + std::to_string(index);
+}
+
+Vector makeVector(int size)
+{
+    Vector vector;
+    for (int x = 0; x < size; x++)
+    {
+        vector.emplace_back(item(x));
+    }
+    return vector;
+}
+
+bool holdsItems(const Vector& vector, int size)
+{
+    if (vector.size() != static_cast<std::size_t>(size))
+    {
+        return false;
+    }
+
+    for (int x = 0; x < size; x++)
+    {
+        if (vector[x].value != item(x))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isInline(const Vector& vector)
+{
+    return vector.capacity() == 3;
+}
+
+} // namespace
+
+TEST_CASE("small_vector/grows_past_inline_capacity")
+{
+    {
+        Vector vector;
+        CHECK(vector.empty());
+
+        for (int x = 0; x < 20; x++)
+        {
+            vector.emplace_back(item(x));
+            CHECK(holdsItems(vector, x + 1));
+            CHECK(vector.capacity() >= vector.size());
+            CHECK(isInline(vector) == (x < 3));
+        }
+
+        CHECK(Tracked::alive == 20);
+    }
+
+    CHECK(Tracked::alive == 0);
+}
+
+TEST_CASE("small_vector/emplace_back_from_own_element_while_growing")
+{
+    {
+        auto vector = makeVector(3);
+        vector.push_back(vector[0]);
+        vector.emplace_back(vector[1]);
+
+        CHECK(vector.size() == 5);
+        CHECK(vector[3].value == item(0));
+        CHECK(vector[4].value == item(1));
+    }
+
+    CHECK(Tracked::alive == 0);
+}
+
+TEST_CASE("small_vector/copy")
+{
+    for (const int size : {0, 2, 3, 4, 10})
+    {
+        {
+            const auto source = makeVector(size);
+
+            Vector copy{source};
+            CHECK(holdsItems(copy, size));
+            CHECK(holdsItems(source, size));
+
+            // Over an inline and over a spilled vector
+            for (const int targetSize : {1, 7})
+            {
+                auto target = makeVector(targetSize);
+                target = source;
+                CHECK(holdsItems(target, size));
+            }
+
+            auto self = makeVector(size);
+            auto& alias = self;
+            self = alias;
+            CHECK(holdsItems(self, size));
+        }
+
+        CHECK(Tracked::alive == 0);
+    }
+}
+
+TEST_CASE("small_vector/move")
+{
+    for (const int size : {0, 2, 3, 4, 10})
+    {
+        {
+            auto source = makeVector(size);
+            const auto* heapElements = source.data();
+
+            Vector moved{std::move(source)};
+            CHECK(holdsItems(moved, size));
+            CHECK(source.empty());
+            CHECK(isInline(source));
+
+            // A spilled buffer is taken over rather than copied
+            if (size > 3)
+            {
+                CHECK(moved.data() == heapElements);
+            }
+
+            source.emplace_back(item(0));
+            CHECK(holdsItems(source, 1));
+
+            for (const int targetSize : {1, 7})
+            {
+                auto target = makeVector(targetSize);
+                auto from = makeVector(size);
+                target = std::move(from);
+                CHECK(holdsItems(target, size));
+                CHECK(from.empty());
+            }
+        }
+
+        CHECK(Tracked::alive == 0);
+    }
+}
+
+TEST_CASE("small_vector/erase")
+{
+    for (const int size : {3, 6})
+    {
+        for (int erased = 0; erased < size; erased++)
+        {
+            {
+                auto vector = makeVector(size);
+                const auto next = vector.erase(vector.begin() + erased);
+
+                CHECK(vector.size() == static_cast<std::size_t>(size - 1));
+                CHECK(next == vector.begin() + erased);
+
+                for (int x = 0; x < size - 1; x++)
+                {
+                    CHECK(vector[x].value == item(x < erased ? x : x + 1));
+                }
+            }
+
+            CHECK(Tracked::alive == 0);
+        }
+    }
+}
+
+TEST_CASE("small_vector/resize_clear_and_at")
+{
+    {
+        auto vector = makeVector(2);
+
+        vector.resize(6);
+        CHECK(vector.size() == 6);
+        CHECK(vector[1].value == item(1));
+        CHECK(vector[5].value.empty());
+
+        vector.resize(1);
+        CHECK(holdsItems(vector, 1));
+        CHECK(Tracked::alive == 1);
+
+        bool threw = false;
+        try
+        {
+            vector.at(1);
+        } catch (const std::out_of_range&)
+        {
+            threw = true;
+        }
+        CHECK(threw);
+
+        vector.clear();
+        CHECK(vector.empty());
+        CHECK(Tracked::alive == 0);
+
+        // Cleared storage is reused
+        vector.emplace_back(item(0));
+        CHECK(holdsItems(vector, 1));
+    }
+
+    CHECK(Tracked::alive == 0);
+}
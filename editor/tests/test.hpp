@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+// Just enough of a test runner for MLSE_tests. TEST_CASE registers a function, a failing CHECK is reported
+// and the case carries on, so one run lists everything that is wrong.
+namespace Test
+{
+
+struct Case
+{
+    std::string_view name;
+    void (*run)();
+};
+
+inline std::vector<Case>& cases()
+{
+    static std::vector<Case> list;
+    return list;
+}
+
+inline int failedChecks = 0;
+
+struct Registrar
+{
+    Registrar(std::string_view name, void (*run)())
+    {
+        cases().push_back({name, run});
+    }
+};
+
+inline void fail(const char* expression, const char* file, int line)
+{
+    std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+    failedChecks++;
+}
+
+} // namespace Test
+
+#define TEST_CONCAT_IMPL(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_IMPL(a, b)
+
+#define TEST_CASE(name)                                                                                          \
+    static void TEST_CONCAT(testCase, __LINE__)();                                                               \
+    static const Test::Registrar TEST_CONCAT(testRegistrar, __LINE__){name, TEST_CONCAT(testCase, __LINE__)};    \
+    static void TEST_CONCAT(testCase, __LINE__)()
+
+#define CHECK(...) ((__VA_ARGS__) ? void() : Test::fail(#__VA_ARGS__, __FILE__, __LINE__))
@@ -0,0 +1,123 @@
+#include "profiler.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using Clock = TraceRecorder::Clock;
+
+// Values of every "key": in the trace, in order
+std::vector<double> values(std::string_view json, std::string_view key)
+{
+    std::string pattern{'"'};
+    pattern.append(key).append("\":");
+
+    std::vector<double> found;
+    for (auto x = json.find(pattern); x != std::string_view::npos; x = json.find(pattern, x + 1))
+    {
+        found.push_back(std::stod(std::string(json.substr(x + pattern.size(), 32))));
+    }
+    return found;
+}
+
+// Starts a new session, dropping whatever an earlier case recorded
+void restart()
+{
+    auto& recorder = TraceRecorder::get();
+    recorder.setRecording(false);
+    recorder.setRecording(true);
+}
+
+} // namespace
+
+TEST_CASE("trace/scopes_record_only_while_recording")
+{
+    auto& recorder = TraceRecorder::get();
+    restart();
+    recorder.setRecording(false);
+
+    {
+        PROFILE_SCOPE("ignored");
+    }
+    CHECK(recorder.eventCount() == 0);
+
+    recorder.setRecording(true);
+    {
+        PROFILE_SCOPE("kept");
+    }
+    CHECK(recorder.eventCount() == 1);
+    CHECK(recorder.toJson().contains(R"("name":"kept","ph":"X")"));
+
+    // Stopping keeps the session for saving, starting again drops it
+    recorder.setRecording(false);
+    CHECK(recorder.eventCount() == 1);
+
+    recorder.setRecording(true);
+    CHECK(recorder.eventCount() == 0);
+
+    recorder.setRecording(false);
+}
+
+TEST_CASE("trace/keeps_the_latest_events_oldest_first")
+{
+    auto& recorder = TraceRecorder::get();
+    restart();
+
+    // Event x lasts x microseconds, so the durations tell which ones survived
+    static constexpr std::size_t overflow = 10;
+    const auto start = Clock::now();
+    for (std::size_t x = 0; x < TraceRecorder::capacity + overflow; x++)
+    {
+        const auto begin = start + std::chrono::microseconds(x);
+        recorder.add("event", begin, begin + std::chrono::microseconds(x));
+    }
+
+    CHECK(recorder.eventCount() == TraceRecorder::capacity);
+
+    const auto json = recorder.toJson();
+    const auto timestamps = values(json, "ts");
+    const auto durations = values(json, "dur");
+
+    CHECK(durations.size() == TraceRecorder::capacity);
+    CHECK(!durations.empty() && durations.front() == double(overflow));
+    CHECK(!durations.empty() && durations.back() == double(TraceRecorder::capacity + overflow - 1));
+    CHECK(std::ranges::is_sorted(timestamps));
+
+    recorder.setRecording(false);
+}
+
+TEST_CASE("trace/writes_trace_event_json")
+{
+    auto& recorder = TraceRecorder::get();
+    restart();
+
+    {
+        PROFILE_SCOPE("main");
+    }
+
+    std::thread worker{[] { PROFILE_SCOPE("worker"); }};
+    worker.join();
+
+    const auto json = recorder.toJson();
+    CHECK(json.starts_with(R"({"displayTimeUnit":"ms","traceEvents":[)"));
+    CHECK(json.ends_with("]}"));
+    CHECK(json.contains(R"("ph":"M")"));
+
+    // The metadata event names the process on tid 0, then one per scope
+    const auto threads = values(json, "tid");
+    CHECK(threads.size() == 3);
+    CHECK(threads.size() == 3 && threads[1] != threads[2] && threads[1] != 0 && threads[2] != 0);
+
+    const auto durations = values(json, "dur");
+    CHECK(durations.size() == 2);
+    CHECK(std::ranges::all_of(durations, [](double duration) { return duration >= 0.0; }));
+
+    recorder.setRecording(false);
+}
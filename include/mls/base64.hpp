@@ -15,6 +15,20 @@
 #include <bit> // For std::bit_cast.
 #endif
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BASE64_HAS_X86_SIMD
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BASE64_TARGET(isa)
+#else
+#include <cpuid.h>
+#define BASE64_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#include <immintrin.h> // SSE4.1 / AVX2 kernels, selected at runtime.
+#endif
+
 namespace base64
 {
 
@@ -357,8 +371,411 @@ constexpr std::array<char, 256> encode_table_1 =
      'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x',
      'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'};
 
+// Instruction sets with a vectorized kernel, in order
+enum class Isa
+{
+    Scalar,
+    Sse41,
+    Avx2
+};
+
 } // namespace detail
 
+#if defined(BASE64_HAS_X86_SIMD)
+
+namespace detail
+{
+
+inline Isa detect_isa() noexcept
+{
+    int regs[4]{};
+
+    const auto cpuid = [&](int leaf, int subleaf)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        __cpuidex(regs, leaf, subleaf);
+#else
+        unsigned int a{}, b{}, c{}, d{};
+        __cpuid_count(leaf, subleaf, a, b, c, d);
+        regs[0] = static_cast<int>(a);
+        regs[1] = static_cast<int>(b);
+        regs[2] = static_cast<int>(c);
+        regs[3] = static_cast<int>(d);
+#endif
+    };
+
+    cpuid(0, 0);
+    const int maxLeaf = regs[0];
+    if (maxLeaf < 1)
+    {
+        return Isa::Scalar;
+    }
+
+    cpuid(1, 0);
+    const bool hasSsse3 = regs[2] & (1 << 9);
+    const bool hasSse41 = regs[2] & (1 << 19);
+    const bool hasOsxsave = regs[2] & (1 << 27);
+    const bool hasAvx = regs[2] & (1 << 28);
+
+    if (!hasSsse3 || !hasSse41)
+    {
+        return Isa::Scalar;
+    }
+
+    if (maxLeaf < 7 || !hasOsxsave || !hasAvx)
+    {
+        return Isa::Sse41;
+    }
+
+    // The OS has to save the ymm registers on context switches for AVX2 to be usable
+#if defined(_MSC_VER) && !defined(__clang__)
+    const auto xcr0 = _xgetbv(0);
+#else
+    std::uint32_t xcr0Lo{}, xcr0Hi{};
+    __asm__("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+    const auto xcr0 = xcr0Lo;
+#endif
+    if ((xcr0 & 0x6) != 0x6)
+    {
+        return Isa::Sse41;
+    }
+
+    cpuid(7, 0);
+    const bool hasAvx2 = regs[1] & (1 << 5);
+
+    return hasAvx2 ? Isa::Avx2 : Isa::Sse41;
+}
+
+inline Isa& selected_isa() noexcept
+{
+    static Isa isa = detect_isa();
+    return isa;
+}
+
+inline Isa active_isa() noexcept
+{
+    return selected_isa();
+}
+
+// Vectorized kernels based on Wojciech Muła's pshufb base64 codec:
+// http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
+// http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html
+// Each kernel only processes whole blocks and returns how much input it consumed,
+// the scalar loops handle the rest.
+
+BASE64_TARGET("ssse3,sse4.1") inline __m128i encode_unpack_sse(__m128i in)
+{
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+    return _mm_or_si128(t1, t3);
+}
+
+BASE64_TARGET("ssse3,sse4.1") inline __m128i encode_lookup_sse(__m128i indices)
+{
+    __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+    const __m128i shiftLut = _mm_setr_epi8('a' - 26,
+                                           '0' - 52,
+                                           '0' - 52,
+                                           '0' - 52,
+                                           '0' - 52,
+                                           '0' - 52,
+                                           '0' - 52,
+                                           '0' - 52,
+                                           '0' - 52,
+                                           '0' - 52,
+                                           '0' - 52,
+                                           '+' - 62,
+                                           '/' - 63,
+                                           'A',
+                                           0,
+                                           0);
+
+    return _mm_add_epi8(_mm_shuffle_epi8(shiftLut, result), indices);
+}
+
+BASE64_TARGET("ssse3,sse4.1") inline size_t encode_sse41(const uint8_t* bytes, size_t size, char* out)
+{
+    size_t consumed = 0;
+
+    // Loads 16 bytes but only uses 12 of them
+    while (size - consumed >= 16)
+    {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + consumed));
+        const __m128i encoded = encode_lookup_sse(encode_unpack_sse(in));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), encoded);
+
+        consumed += 12;
+        out += 16;
+    }
+
+    return consumed;
+}
+
+BASE64_TARGET("avx2") inline size_t encode_avx2(const uint8_t* bytes, size_t size, char* out)
+{
+    size_t consumed = 0;
+
+    const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+
+    const __m256i shiftLut = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0,
+                                              'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0);
+
+    // Two 12 byte groups per iteration, the upper load reads 4 bytes past the group
+    while (size - consumed >= 28)
+    {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + consumed));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + consumed + 12));
+        __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+        in = _mm256_shuffle_epi8(in, shuffle);
+
+        const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        result = _mm256_add_epi8(_mm256_shuffle_epi8(shiftLut, result), indices);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), result);
+
+        consumed += 24;
+        out += 32;
+    }
+
+    return consumed + encode_sse41(bytes + consumed, size - consumed, out);
+}
+
+// Translates 16 ascii characters to their 6 bit values, returns false on any invalid character
+BASE64_TARGET("ssse3,sse4.1") inline bool decode_lookup_sse(__m128i in, __m128i& values)
+{
+    const __m128i higherNibble = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+    const __m128i lowerNibble = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+
+    const __m128i shiftLut = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    const __m128i maskLut = _mm_setr_epi8(static_cast<char>(0xa8),
+                                          static_cast<char>(0xf8),
+                                          static_cast<char>(0xf8),
+                                          static_cast<char>(0xf8),
+                                          static_cast<char>(0xf8),
+                                          static_cast<char>(0xf8),
+                                          static_cast<char>(0xf8),
+                                          static_cast<char>(0xf8),
+                                          static_cast<char>(0xf8),
+                                          static_cast<char>(0xf8),
+                                          static_cast<char>(0xf0),
+                                          0x54,
+                                          0x50,
+                                          0x50,
+                                          0x50,
+                                          0x54);
+
+    const __m128i bitposLut = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, static_cast<char>(0x80),
+                                            0, 0, 0, 0, 0, 0, 0, 0);
+
+    const __m128i shiftBase = _mm_shuffle_epi8(shiftLut, higherNibble);
+    const __m128i isSlash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+    const __m128i shift = _mm_blendv_epi8(shiftBase, _mm_set1_epi8(16), isSlash);
+
+    const __m128i mask = _mm_shuffle_epi8(maskLut, lowerNibble);
+    const __m128i bit = _mm_shuffle_epi8(bitposLut, higherNibble);
+    const __m128i nonMatch = _mm_cmpeq_epi8(_mm_and_si128(mask, bit), _mm_setzero_si128());
+
+    if (_mm_movemask_epi8(nonMatch))
+    {
+        return false;
+    }
+
+    values = _mm_add_epi8(in, shift);
+    return true;
+}
+
+BASE64_TARGET("ssse3,sse4.1") inline __m128i decode_pack_sse(__m128i values)
+{
+    const __m128i mergedAB = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i merged = _mm_madd_epi16(mergedAB, _mm_set1_epi32(0x00011000));
+
+    return _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+BASE64_TARGET("ssse3,sse4.1") inline size_t decode_sse41(const uint8_t* chars, size_t size, char* out)
+{
+    size_t consumed = 0;
+
+    // Stores 16 bytes but only produces 12, keep enough input so the store stays within the output
+    while (size - consumed >= 24)
+    {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + consumed));
+
+        __m128i values;
+        if (!decode_lookup_sse(in, values))
+        {
+            throw std::runtime_error{"Invalid base64 encoded data - Invalid character"};
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), decode_pack_sse(values));
+
+        consumed += 16;
+        out += 12;
+    }
+
+    return consumed;
+}
+
+BASE64_TARGET("avx2") inline size_t decode_avx2(const uint8_t* chars, size_t size, char* out)
+{
+    size_t consumed = 0;
+
+    const __m256i shiftLut = _mm256_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    const auto c = [](int v) { return static_cast<char>(v); };
+    const __m256i maskLut = _mm256_setr_epi8(c(0xa8), c(0xf8), c(0xf8), c(0xf8), c(0xf8), c(0xf8), c(0xf8), c(0xf8),
+                                             c(0xf8), c(0xf8), c(0xf0), 0x54, 0x50, 0x50, 0x50, 0x54,
+                                             c(0xa8), c(0xf8), c(0xf8), c(0xf8), c(0xf8), c(0xf8), c(0xf8), c(0xf8),
+                                             c(0xf8), c(0xf8), c(0xf0), 0x54, 0x50, 0x50, 0x50, 0x54);
+
+    const __m256i bitposLut = _mm256_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, c(0x80),
+                                               0, 0, 0, 0, 0, 0, 0, 0,
+                                               0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, c(0x80),
+                                               0, 0, 0, 0, 0, 0, 0, 0);
+
+    const __m256i packShuffle = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    // Stores 32 bytes but only produces 24, keep enough input so the store stays within the output
+    while (size - consumed >= 44)
+    {
+        const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chars + consumed));
+
+        const __m256i higherNibble = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0f));
+        const __m256i lowerNibble = _mm256_and_si256(in, _mm256_set1_epi8(0x0f));
+
+        const __m256i shiftBase = _mm256_shuffle_epi8(shiftLut, higherNibble);
+        const __m256i isSlash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+        const __m256i shift = _mm256_blendv_epi8(shiftBase, _mm256_set1_epi8(16), isSlash);
+
+        const __m256i mask = _mm256_shuffle_epi8(maskLut, lowerNibble);
+        const __m256i bit = _mm256_shuffle_epi8(bitposLut, higherNibble);
+        const __m256i nonMatch = _mm256_cmpeq_epi8(_mm256_and_si256(mask, bit), _mm256_setzero_si256());
+
+        if (_mm256_movemask_epi8(nonMatch))
+        {
+            throw std::runtime_error{"Invalid base64 encoded data - Invalid character"};
+        }
+
+        const __m256i values = _mm256_add_epi8(in, shift);
+
+        const __m256i mergedAB = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        const __m256i merged = _mm256_madd_epi16(mergedAB, _mm256_set1_epi32(0x00011000));
+        const __m256i packedLanes = _mm256_shuffle_epi8(merged, packShuffle);
+        const __m256i packed = _mm256_permutevar8x32_epi32(packedLanes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), packed);
+
+        consumed += 32;
+        out += 24;
+    }
+
+    return consumed + decode_sse41(chars + consumed, size - consumed, out);
+}
+
+inline size_t encode_simd(const uint8_t* bytes, size_t size, char* out)
+{
+    switch (active_isa())
+    {
+        case Isa::Avx2:
+        {
+            return encode_avx2(bytes, size, out);
+        }
+        case Isa::Sse41:
+        {
+            return encode_sse41(bytes, size, out);
+        }
+        default:
+        {
+            return 0;
+        }
+    }
+}
+
+inline size_t decode_simd(const uint8_t* chars, size_t size, char* out)
+{
+    switch (active_isa())
+    {
+        case Isa::Avx2:
+        {
+            return decode_avx2(chars, size, out);
+        }
+        case Isa::Sse41:
+        {
+            return decode_sse41(chars, size, out);
+        }
+        default:
+        {
+            return 0;
+        }
+    }
+}
+
+} // namespace detail
+
+#undef BASE64_TARGET
+
+#else
+
+namespace detail
+{
+
+inline Isa detect_isa() noexcept
+{
+    return Isa::Scalar;
+}
+
+inline Isa& selected_isa() noexcept
+{
+    static Isa isa = Isa::Scalar;
+    return isa;
+}
+
+inline size_t encode_simd(const uint8_t*, size_t, char*)
+{
+    return 0;
+}
+
+inline size_t decode_simd(const uint8_t*, size_t, char*)
+{
+    return 0;
+}
+
+} // namespace detail
+
+#endif
+
+// Limits the kernels to isa and below, clamped to what the CPU supports. For tests and benchmarks comparing
+// them against the scalar code, not thread safe.
+inline void set_max_isa(detail::Isa isa) noexcept
+{
+    detail::selected_isa() = std::min(isa, detail::detect_isa());
+}
+
 template <class OutputBuffer, class InputIterator>
 inline OutputBuffer encode_into(InputIterator begin, InputIterator end)
 {
@@ -375,7 +792,11 @@ inline OutputBuffer encode_into(InputIterator begin, InputIterator end)
     const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&*begin);
     char* currEncoding = reinterpret_cast<char*>(&encoded[0]);
 
-    for (size_t i = binarytextsize / 3; i; --i)
+    const size_t simdConsumed = detail::encode_simd(bytes, binarytextsize, currEncoding);
+    bytes += simdConsumed;
+    currEncoding += simdConsumed / 3 * 4;
+
+    for (size_t i = (binarytextsize - simdConsumed) / 3; i; --i)
     {
         const uint8_t t1 = *bytes++;
         const uint8_t t2 = *bytes++;
@@ -459,7 +880,13 @@ inline OutputBuffer decode_into(std::string_view base64Text)
     const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&base64Text[0]);
     char* currDecoding = reinterpret_cast<char*>(&decoded[0]);
 
-    for (size_t i = (base64Text.size() >> 2) - (numPadding != 0); i; --i)
+    // The padded quad at the end is always left to the scalar code below
+    const size_t fullQuadChars = base64Text.size() - (numPadding != 0 ? 4 : 0);
+    const size_t simdConsumed = detail::decode_simd(bytes, fullQuadChars, currDecoding);
+    bytes += simdConsumed;
+    currDecoding += simdConsumed / 4 * 3;
+
+    for (size_t i = (fullQuadChars - simdConsumed) >> 2; i; --i)
     {
         const uint8_t t1 = *bytes++;
         const uint8_t t2 = *bytes++;
@@ -10,6 +10,17 @@
 
 using json = nlohmann::json;
 
+namespace mls::detail
+{
+// The free serialize() overloads are declared after Serializer, and anywhere the types they handle are. An unqualified
+// call finds them by argument-dependent lookup where it's instantiated, which a call to ::serialize doesn't.
+template <typename S, typename T>
+void serializeFree(S& s, T& t)
+{
+    serialize(s, t);
+}
+} // namespace mls::detail
+
 struct Serializer
 {
     bool isSaving;
@@ -43,14 +54,14 @@ struct Serializer
     template <typename T>
     void serialize(T& t)
     {
-        ::serialize(*this, t);
+        mls::detail::serializeFree(*this, t);
     }
 
     template <typename T>
     void serialize(std::string_view name, T& t)
     {
         auto ss = at(name);
-        ::serialize(ss, t);
+        mls::detail::serializeFree(ss, t);
     }
 
     template <typename R, typename W>
@@ -192,22 +203,36 @@ void serialize(Serializer& s, std::pair<Key, Value>& pair)
 template <typename Key, typename Value>
 void serialize(Serializer& s, std::unordered_map<Key, Value>& map)
 {
-    using Pair = std::pair<Key, Value>;
+    if (s.isSaving)
+    {
+        // Sorted by key and in place, the values can be expensive or impossible to copy
+        std::vector<std::pair<const Key, Value>*> pairs;
+        for (auto& pair : map)
+        {
+            pairs.push_back(&pair);
+        }
+        std::ranges::sort(pairs, {}, [](const auto* pair) -> const Key& { return pair->first; });
 
-    s.serializeValue<std::vector<Pair>>(
-        [&]()
+        for (std::size_t x = 0; x < pairs.size(); x++)
         {
-            std::vector<Pair> pairs;
-            for (const auto& pair : map)
-            {
-                pairs.push_back(pair);
-            }
-            std::ranges::sort(pairs, {}, &Pair::first);
-            return pairs;
-        },
-        [&](auto& pairs) {
-            map = {pairs.begin(), pairs.end()};
-        });
+            auto key = pairs[x]->first;
+
+            auto ss = s.at(x);
+            ss.at(0).serialize(key);
+            ss.at(1).serialize(pairs[x]->second);
+        }
+    }
+    else
+    {
+        std::vector<std::pair<Key, Value>> pairs;
+        s.serialize(pairs);
+
+        map.clear();
+        for (auto& [key, value] : pairs)
+        {
+            map.emplace(std::move(key), std::move(value));
+        }
+    }
 }
 
 template <typename T>